@@ -28,6 +28,9 @@ G_GNUC_INTERNAL
 void		_gspell_checker_force_set_language	(GspellChecker        *checker,
 							 const GspellLanguage *language);
 
+G_GNUC_INTERNAL
+gboolean	_gspell_checker_is_thread_safe		(GspellChecker        *checker);
+
 G_END_DECLS
 
 #endif  /* GSPELL_CHECKER_PRIVATE_H */
@@ -24,6 +24,8 @@
 
 #include <stdio.h>
 #include "gspell-checker.h"
+#include "gspell-checker-private.h"
+#include "gspell-enchant-checker.h"
 
 enum
 {
@@ -315,6 +317,18 @@ gspell_checker_session_cleared		(GspellChecker *checker)
   	g_signal_emit (checker, signals [SIGNAL_SESSION_CLEARED], 0);
 }
 
+/* Whether gspell_checker_check_word() can be called from another thread than
+ * the main thread. Only for the enchant checker itself, a subclass can
+ * re-implement the GspellChecker interface.
+ */
+gboolean
+_gspell_checker_is_thread_safe (GspellChecker *checker)
+{
+	g_return_val_if_fail (GSPELL_IS_CHECKER (checker), FALSE);
+
+	return G_TYPE_FROM_INSTANCE (checker) == GSPELL_TYPE_ENCHANT_CHECKER;
+}
+
 /* ex:set ts=8 noet: */
 
 
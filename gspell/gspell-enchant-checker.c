@@ -20,6 +20,7 @@
 #include "config.h"
 #include "gspell-enchant-checker.h"
 #include <glib/gi18n-lib.h>
+#include "gspell-checker-private.h"
 #include "gspell-utils.h"
 
 typedef struct _GspellEnchantCheckerPrivate GspellEnchantCheckerPrivate;
@@ -29,6 +30,11 @@ struct _GspellEnchantCheckerPrivate
 	const GspellLanguage * active_lang;
 	EnchantBroker *broker;
 	EnchantDict *dict;
+
+	/* Protects the dict, so that words can be checked from the inline
+	 * checker worker threads. Enchant dictionaries are not thread-safe.
+	 */
+	GMutex dict_mutex;
 };
 
 enum
@@ -57,13 +63,18 @@ gspell_enchant_checker_add_word_to_personal(GspellChecker *checker,
 
 	priv = gspell_enchant_checker_get_instance_private (GSPELL_ENCHANT_CHECKER(checker));
 
+	g_mutex_lock (&priv->dict_mutex);
+
 	if (priv->dict == NULL)
 	{
+		g_mutex_unlock (&priv->dict_mutex);
 		return;
 	}
 
 	enchant_dict_add (priv->dict, word, word_length);
 
+	g_mutex_unlock (&priv->dict_mutex);
+
 	if (word_length == -1)
 	{
 		gspell_checker_word_added_to_personal (checker, word);
@@ -90,13 +101,16 @@ gspell_enchant_checker_check_word (GspellChecker  *checker,
 
 	priv = gspell_enchant_checker_get_instance_private (GSPELL_ENCHANT_CHECKER(checker));
 
-	if (priv->dict == NULL)
+	if (_gspell_utils_is_number (word, word_length))
 	{
 		return TRUE;
 	}
 
-	if (_gspell_utils_is_number (word, word_length))
+	g_mutex_lock (&priv->dict_mutex);
+
+	if (priv->dict == NULL)
 	{
+		g_mutex_unlock (&priv->dict_mutex);
 		return TRUE;
 	}
 
@@ -133,6 +147,8 @@ gspell_enchant_checker_check_word (GspellChecker  *checker,
 		g_free (nul_terminated_word);
 	}
 
+	g_mutex_unlock (&priv->dict_mutex);
+
 	return correctly_spelled;
 }
 
@@ -149,8 +165,11 @@ gspell_enchant_checker_get_suggestions	(GspellChecker *checker,
 
 	priv = gspell_enchant_checker_get_instance_private (GSPELL_ENCHANT_CHECKER(checker));
 
+	g_mutex_lock (&priv->dict_mutex);
+
 	if (priv->dict == NULL)
 	{
+		g_mutex_unlock (&priv->dict_mutex);
 		return NULL;
 	}
 
@@ -164,6 +183,8 @@ gspell_enchant_checker_get_suggestions	(GspellChecker *checker,
 		suggestions = enchant_dict_suggest (priv->dict, word, word_length, NULL);
 	}
 
+	g_mutex_unlock (&priv->dict_mutex);
+
 	if (suggestions == NULL)
 	{
 		return NULL;
@@ -189,13 +210,18 @@ gspell_enchant_checker_add_word_to_session	(GspellChecker *checker,
 
 	priv = gspell_enchant_checker_get_instance_private (GSPELL_ENCHANT_CHECKER(checker));
 
+	g_mutex_lock (&priv->dict_mutex);
+
 	if (priv->dict == NULL)
 	{
+		g_mutex_unlock (&priv->dict_mutex);
 		return;
 	}
 
 	enchant_dict_add_to_session (priv->dict, word, word_length);
 
+	g_mutex_unlock (&priv->dict_mutex);
+
 	if (word_length == -1)
 	{
 		gspell_checker_word_added_to_session (checker, word);
@@ -221,14 +247,16 @@ gspell_enchant_checker_set_correction	(GspellChecker *checker,
 
 	priv = gspell_enchant_checker_get_instance_private (GSPELL_ENCHANT_CHECKER(checker));
 
-	if (priv->dict == NULL)
+	g_mutex_lock (&priv->dict_mutex);
+
+	if (priv->dict != NULL)
 	{
-		return;
+		enchant_dict_store_replacement (priv->dict,
+						word, word_length,
+						replacement, replacement_length);
 	}
 
-	enchant_dict_store_replacement (priv->dict,
-					word, word_length,
-					replacement, replacement_length);
+	g_mutex_unlock (&priv->dict_mutex);
 }
 
 static void
@@ -334,6 +362,18 @@ gspell_enchant_checker_get_property	(GObject    *object,
 	}
 }
 
+static void
+gspell_enchant_checker_finalize (GObject *object)
+{
+	GspellEnchantCheckerPrivate *priv;
+
+	priv = gspell_enchant_checker_get_instance_private (GSPELL_ENCHANT_CHECKER (object));
+
+	g_mutex_clear (&priv->dict_mutex);
+
+	G_OBJECT_CLASS (gspell_enchant_checker_parent_class)->finalize (object);
+}
+
 static void
 gspell_enchant_checker_class_init (GspellEnchantCheckerClass * klass)
 {
@@ -341,6 +381,7 @@ gspell_enchant_checker_class_init (GspellEnchantCheckerClass * klass)
 
 	object_class->set_property = gspell_enchant_checker_set_property;
 	object_class->get_property = gspell_enchant_checker_get_property;
+	object_class->finalize = gspell_enchant_checker_finalize;
 
 	g_object_class_override_property (object_class, PROP_LANGUAGE, "language");
 }
@@ -354,6 +395,7 @@ gspell_enchant_checker_init (GspellEnchantChecker * self)
 
 	priv->broker = enchant_broker_init ();
 	priv->dict = NULL;
+	g_mutex_init (&priv->dict_mutex);
 }
 
 static void
@@ -361,9 +403,12 @@ create_new_dictionary (GspellEnchantChecker *checker)
 {
 	GspellEnchantCheckerPrivate *priv;
 	const gchar *language_code;
+	gboolean has_dict;
 
 	priv = gspell_enchant_checker_get_instance_private (checker);
 
+	g_mutex_lock (&priv->dict_mutex);
+
 	if (priv->dict != NULL)
 	{
 		enchant_broker_free_dict (priv->broker, priv->dict);
@@ -372,8 +417,11 @@ create_new_dictionary (GspellEnchantChecker *checker)
 
 	language_code = gspell_language_get_code (priv->active_lang);
 	priv->dict = enchant_broker_request_dict (priv->broker, language_code);
+	has_dict = priv->dict != NULL;
 
-	if (priv->dict == NULL)
+	g_mutex_unlock (&priv->dict_mutex);
+
+	if (!has_dict)
 	{
 		/* Should never happen, no need to return a GError. */
 		g_warning ("Impossible to create an Enchant dictionary for the language code '%s'.",
@@ -393,6 +441,12 @@ create_new_dictionary (GspellEnchantChecker *checker)
  * #GspellEnchantChecker re-creates a new EnchantDict when the #GspellChecker:language
  * is changed and when the session is cleared.
  *
+ * The inline spell checker of #GspellTextView can check words with @checker
+ * from worker threads, and an EnchantDict is not thread-safe. So the returned
+ * EnchantDict must not be used while a #GspellTextView with
+ * #GspellTextView:inline-spell-checking enabled is being spell-checked. To
+ * modify the dictionary, prefer the #GspellChecker API.
+ *
  * Returns: (transfer none) (nullable): the #EnchantDict currently used by
  * @checker.
  * Since: 4.0
@@ -426,7 +480,6 @@ gspell_enchant_checker_new (const GspellLanguage *language)
 			NULL);
 }
 
-
 /* ex:set ts=8 noet: */
 
 
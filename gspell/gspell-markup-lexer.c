@@ -0,0 +1,980 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gspell-markup-lexer.h"
+#include <string.h>
+
+/* Lightweight lexers for the markup languages of #GspellMarkupMode.
+ *
+ * The lexers don't build a syntax tree, they only mark the characters that are
+ * not prose: tags, commands, link targets, code, etc. The words overlapping
+ * those characters are then removed from the PangoLogAttr array, so they never
+ * reach the spell checker.
+ *
+ * The lexers work line by line, without state carried over from the previous
+ * lines. It permits to lex only the lines that need to be re-checked. As a
+ * consequence, constructs spanning several lines (fenced code blocks,
+ * multi-line HTML comments, display math, etc) are recognized only on the
+ * lines containing their delimiters.
+ */
+
+typedef struct _Lexer Lexer;
+
+struct _Lexer
+{
+	gunichar *chars;
+	glong n_chars;
+
+	/* Array of n_chars elements. */
+	gboolean *excluded;
+};
+
+/* A LexFunc tries to recognize a construct starting at @pos. It returns the
+ * position after the construct, or @pos if no construct has been recognized.
+ */
+typedef glong (* LexFunc) (Lexer *lexer,
+			   glong  pos);
+
+static void
+exclude (Lexer *lexer,
+	 glong  start,
+	 glong  end)
+{
+	glong pos;
+
+	start = MAX (start, 0);
+	end = MIN (end, lexer->n_chars);
+
+	for (pos = start; pos < end; pos++)
+	{
+		lexer->excluded[pos] = TRUE;
+	}
+}
+
+static gboolean
+is_ascii_letter (gunichar ch)
+{
+	return ch < 128 && g_ascii_isalpha (ch);
+}
+
+static gboolean
+is_ascii_char_in_set (gunichar     ch,
+		      const gchar *set)
+{
+	return ch != '\0' && ch < 128 && strchr (set, (gchar) ch) != NULL;
+}
+
+static gboolean
+match_ascii (const Lexer *lexer,
+	     glong        pos,
+	     const gchar *str)
+{
+	for (; *str != '\0'; str++, pos++)
+	{
+		if (pos >= lexer->n_chars ||
+		    lexer->chars[pos] != (gunichar) *str)
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+at_line_start (const Lexer *lexer,
+	       glong        pos)
+{
+	return pos == 0 || lexer->chars[pos - 1] == '\n';
+}
+
+static glong
+get_line_end (const Lexer *lexer,
+	      glong        pos)
+{
+	while (pos < lexer->n_chars && lexer->chars[pos] != '\n')
+	{
+		pos++;
+	}
+
+	return pos;
+}
+
+static glong
+skip_blanks (const Lexer *lexer,
+	     glong        pos)
+{
+	while (pos < lexer->n_chars &&
+	       (lexer->chars[pos] == ' ' || lexer->chars[pos] == '\t'))
+	{
+		pos++;
+	}
+
+	return pos;
+}
+
+/* Returns the position of @str in the current line, or -1 if not found. */
+static glong
+find_ascii_in_line (const Lexer *lexer,
+		    glong        pos,
+		    const gchar *str)
+{
+	for (; pos < lexer->n_chars && lexer->chars[pos] != '\n'; pos++)
+	{
+		if (match_ascii (lexer, pos, str))
+		{
+			return pos;
+		}
+	}
+
+	return -1;
+}
+
+/* @pos must be on the opening character. Returns the position after the
+ * closing character, or the line end if the group is not closed.
+ */
+static glong
+skip_group (const Lexer *lexer,
+	    glong        pos,
+	    gunichar     opening,
+	    gunichar     closing)
+{
+	gint depth = 0;
+
+	for (; pos < lexer->n_chars && lexer->chars[pos] != '\n'; pos++)
+	{
+		if (lexer->chars[pos] == opening)
+		{
+			depth++;
+		}
+		else if (lexer->chars[pos] == closing)
+		{
+			depth--;
+
+			if (depth == 0)
+			{
+				return pos + 1;
+			}
+		}
+	}
+
+	return pos;
+}
+
+static void
+lex (Lexer         *lexer,
+     const LexFunc *funcs,
+     guint          n_funcs)
+{
+	glong pos = 0;
+
+	while (pos < lexer->n_chars)
+	{
+		glong next_pos = pos;
+		guint func_num;
+
+		for (func_num = 0; func_num < n_funcs && next_pos == pos; func_num++)
+		{
+			next_pos = funcs[func_num] (lexer, pos);
+		}
+
+		pos = next_pos > pos ? next_pos : pos + 1;
+	}
+}
+
+/* Common to all markup languages. */
+
+static glong
+lex_url (Lexer *lexer,
+	 glong  pos)
+{
+	glong end;
+
+	if (pos > 0 && g_unichar_isalnum (lexer->chars[pos - 1]))
+	{
+		return pos;
+	}
+
+	if (!match_ascii (lexer, pos, "http://") &&
+	    !match_ascii (lexer, pos, "https://") &&
+	    !match_ascii (lexer, pos, "ftp://") &&
+	    !match_ascii (lexer, pos, "mailto:") &&
+	    !match_ascii (lexer, pos, "www."))
+	{
+		return pos;
+	}
+
+	end = pos;
+	while (end < lexer->n_chars &&
+	       !g_unichar_isspace (lexer->chars[end]) &&
+	       !is_ascii_char_in_set (lexer->chars[end], "<>\"`"))
+	{
+		end++;
+	}
+
+	/* Trailing punctuation most probably belongs to the sentence. */
+	while (end > pos && is_ascii_char_in_set (lexer->chars[end - 1], ".,;:!?)]'"))
+	{
+		end--;
+	}
+
+	exclude (lexer, pos, end);
+	return end;
+}
+
+/* HTML/XML */
+
+static glong
+lex_html_comment_or_tag (Lexer *lexer,
+			 glong  pos)
+{
+	gunichar next_char;
+	glong end;
+
+	if (lexer->chars[pos] != '<' ||
+	    pos + 1 >= lexer->n_chars)
+	{
+		return pos;
+	}
+
+	if (match_ascii (lexer, pos, "<!--"))
+	{
+		end = find_ascii_in_line (lexer, pos + 4, "-->");
+		end = end != -1 ? end + 3 : get_line_end (lexer, pos);
+
+		exclude (lexer, pos, end);
+		return end;
+	}
+
+	next_char = lexer->chars[pos + 1];
+	if (!g_unichar_isalpha (next_char) &&
+	    !is_ascii_char_in_set (next_char, "/!?"))
+	{
+		return pos;
+	}
+
+	/* A tag with its attributes, or an autolink in Markdown. If the tag
+	 * continues on the next line, exclude the remaining of the line.
+	 */
+	end = find_ascii_in_line (lexer, pos + 1, ">");
+	end = end != -1 ? end + 1 : get_line_end (lexer, pos);
+
+	exclude (lexer, pos, end);
+	return end;
+}
+
+static glong
+lex_html_entity (Lexer *lexer,
+		 glong  pos)
+{
+	glong name_start;
+	glong end;
+
+	if (lexer->chars[pos] != '&')
+	{
+		return pos;
+	}
+
+	name_start = pos + 1;
+	if (name_start < lexer->n_chars && lexer->chars[name_start] == '#')
+	{
+		name_start++;
+	}
+
+	end = name_start;
+	while (end < lexer->n_chars && g_unichar_isalnum (lexer->chars[end]))
+	{
+		end++;
+	}
+
+	if (end == name_start ||
+	    end >= lexer->n_chars ||
+	    lexer->chars[end] != ';')
+	{
+		return pos;
+	}
+
+	exclude (lexer, pos, end + 1);
+	return end + 1;
+}
+
+static void
+lex_html (Lexer *lexer)
+{
+	static const LexFunc funcs[] =
+	{
+		lex_html_comment_or_tag,
+		lex_html_entity,
+		lex_url,
+	};
+
+	lex (lexer, funcs, G_N_ELEMENTS (funcs));
+}
+
+/* Markdown */
+
+static glong
+lex_markdown_fence_line (Lexer *lexer,
+			 glong  pos)
+{
+	glong p;
+	glong end;
+
+	if (!at_line_start (lexer, pos))
+	{
+		return pos;
+	}
+
+	p = skip_blanks (lexer, pos);
+
+	if (!match_ascii (lexer, p, "```") &&
+	    !match_ascii (lexer, p, "~~~"))
+	{
+		return pos;
+	}
+
+	/* The fence with its info string. */
+	end = get_line_end (lexer, pos);
+	exclude (lexer, pos, end);
+	return end;
+}
+
+/* [label]: destination "title" */
+static glong
+lex_markdown_reference_definition (Lexer *lexer,
+				   glong  pos)
+{
+	glong p;
+	glong end;
+
+	if (!at_line_start (lexer, pos))
+	{
+		return pos;
+	}
+
+	p = skip_blanks (lexer, pos);
+	if (p >= lexer->n_chars || lexer->chars[p] != '[')
+	{
+		return pos;
+	}
+
+	p = skip_group (lexer, p, '[', ']');
+	if (!match_ascii (lexer, p, ":"))
+	{
+		return pos;
+	}
+
+	end = get_line_end (lexer, pos);
+	exclude (lexer, pos, end);
+	return end;
+}
+
+static glong
+lex_markdown_code_span (Lexer *lexer,
+			glong  pos)
+{
+	glong run_length;
+	glong p;
+
+	if (lexer->chars[pos] != '`')
+	{
+		return pos;
+	}
+
+	run_length = 0;
+	while (pos + run_length < lexer->n_chars &&
+	       lexer->chars[pos + run_length] == '`')
+	{
+		run_length++;
+	}
+
+	p = pos + run_length;
+	while (p < lexer->n_chars && lexer->chars[p] != '\n')
+	{
+		glong closing_run_length = 0;
+
+		while (p + closing_run_length < lexer->n_chars &&
+		       lexer->chars[p + closing_run_length] == '`')
+		{
+			closing_run_length++;
+		}
+
+		if (closing_run_length == 0)
+		{
+			p++;
+		}
+		else if (closing_run_length == run_length)
+		{
+			exclude (lexer, pos, p + run_length);
+			return p + run_length;
+		}
+		else
+		{
+			p += closing_run_length;
+		}
+	}
+
+	/* Not a code span, but skip the whole backtick string. */
+	return pos + run_length;
+}
+
+/* The destination of [text](destination) and the label of [text][label]. */
+static glong
+lex_markdown_link_destination (Lexer *lexer,
+			       glong  pos)
+{
+	glong end;
+
+	if (match_ascii (lexer, pos, "]("))
+	{
+		end = skip_group (lexer, pos + 1, '(', ')');
+	}
+	else if (match_ascii (lexer, pos, "]["))
+	{
+		end = skip_group (lexer, pos + 1, '[', ']');
+	}
+	else
+	{
+		return pos;
+	}
+
+	exclude (lexer, pos + 1, end);
+	return end;
+}
+
+static void
+lex_markdown (Lexer *lexer)
+{
+	static const LexFunc funcs[] =
+	{
+		lex_markdown_fence_line,
+		lex_markdown_reference_definition,
+		lex_markdown_code_span,
+		lex_markdown_link_destination,
+		lex_html_comment_or_tag,
+		lex_html_entity,
+		lex_url,
+	};
+
+	lex (lexer, funcs, G_N_ELEMENTS (funcs));
+}
+
+/* LaTeX */
+
+/* The commands whose first argument is not prose: labels, references,
+ * environment names, file names, etc.
+ */
+static const gchar *latex_commands_with_non_prose_argument[] =
+{
+	"autoref",
+	"begin",
+	"bibliography",
+	"bibliographystyle",
+	"cite",
+	"citep",
+	"citet",
+	"Cref",
+	"cref",
+	"documentclass",
+	"end",
+	"eqref",
+	"href",
+	"hspace",
+	"include",
+	"includegraphics",
+	"input",
+	"label",
+	"newcommand",
+	"nocite",
+	"pageref",
+	"ref",
+	"renewcommand",
+	"setlength",
+	"url",
+	"usepackage",
+	"vspace",
+};
+
+static gboolean
+latex_command_has_non_prose_argument (const Lexer *lexer,
+				      glong        name_start,
+				      glong        name_end)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (latex_commands_with_non_prose_argument); i++)
+	{
+		const gchar *name = latex_commands_with_non_prose_argument[i];
+
+		if ((glong) strlen (name) == name_end - name_start &&
+		    match_ascii (lexer, name_start, name))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static glong
+lex_latex_comment (Lexer *lexer,
+		   glong  pos)
+{
+	glong end;
+
+	/* An escaped \% is eaten by lex_latex_command(). */
+	if (lexer->chars[pos] != '%')
+	{
+		return pos;
+	}
+
+	end = get_line_end (lexer, pos);
+	exclude (lexer, pos, end);
+	return end;
+}
+
+static glong
+lex_latex_math (Lexer *lexer,
+		glong  pos)
+{
+	const gchar *opening;
+	const gchar *closing;
+	glong closing_pos;
+	glong end;
+
+	if (match_ascii (lexer, pos, "$$"))
+	{
+		opening = closing = "$$";
+	}
+	else if (match_ascii (lexer, pos, "$"))
+	{
+		opening = closing = "$";
+	}
+	else if (match_ascii (lexer, pos, "\\("))
+	{
+		opening = "\\(";
+		closing = "\\)";
+	}
+	else if (match_ascii (lexer, pos, "\\["))
+	{
+		opening = "\\[";
+		closing = "\\]";
+	}
+	else
+	{
+		return pos;
+	}
+
+	closing_pos = find_ascii_in_line (lexer, pos + strlen (opening), closing);
+	if (closing_pos == -1)
+	{
+		/* Probably display math spanning several lines. */
+		end = pos + strlen (opening);
+	}
+	else
+	{
+		end = closing_pos + strlen (closing);
+	}
+
+	exclude (lexer, pos, end);
+	return end;
+}
+
+static glong
+lex_latex_command (Lexer *lexer,
+		   glong  pos)
+{
+	glong name_start;
+	glong name_end;
+	glong end;
+
+	if (lexer->chars[pos] != '\\' ||
+	    pos + 1 >= lexer->n_chars)
+	{
+		return pos;
+	}
+
+	name_start = pos + 1;
+
+	/* Control symbol, like \% or \\. */
+	if (!is_ascii_letter (lexer->chars[name_start]))
+	{
+		exclude (lexer, pos, pos + 2);
+		return pos + 2;
+	}
+
+	name_end = name_start;
+	while (name_end < lexer->n_chars && is_ascii_letter (lexer->chars[name_end]))
+	{
+		name_end++;
+	}
+
+	end = name_end;
+	if (end < lexer->n_chars && lexer->chars[end] == '*')
+	{
+		end++;
+	}
+
+	if (latex_command_has_non_prose_argument (lexer, name_start, name_end))
+	{
+		/* Optional arguments, then the first mandatory argument. */
+		end = skip_blanks (lexer, end);
+		while (end < lexer->n_chars && lexer->chars[end] == '[')
+		{
+			end = skip_group (lexer, end, '[', ']');
+			end = skip_blanks (lexer, end);
+		}
+
+		if (end < lexer->n_chars && lexer->chars[end] == '{')
+		{
+			end = skip_group (lexer, end, '{', '}');
+		}
+	}
+
+	exclude (lexer, pos, end);
+	return end;
+}
+
+static void
+lex_latex (Lexer *lexer)
+{
+	static const LexFunc funcs[] =
+	{
+		lex_latex_math,
+		lex_latex_command,
+		lex_latex_comment,
+		lex_url,
+	};
+
+	lex (lexer, funcs, G_N_ELEMENTS (funcs));
+}
+
+/* reStructuredText */
+
+/* Directives, comments, hyperlink targets and substitution definitions. */
+static glong
+lex_rest_explicit_markup (Lexer *lexer,
+			  glong  pos)
+{
+	glong p;
+	glong end;
+
+	if (!at_line_start (lexer, pos))
+	{
+		return pos;
+	}
+
+	p = skip_blanks (lexer, pos);
+	if (!match_ascii (lexer, p, "..") ||
+	    (p + 2 < lexer->n_chars && !g_unichar_isspace (lexer->chars[p + 2])))
+	{
+		return pos;
+	}
+
+	end = get_line_end (lexer, pos);
+	exclude (lexer, pos, end);
+	return end;
+}
+
+static glong
+lex_rest_field_name (Lexer *lexer,
+		     glong  pos)
+{
+	glong p;
+	glong closing_pos;
+
+	if (!at_line_start (lexer, pos))
+	{
+		return pos;
+	}
+
+	p = skip_blanks (lexer, pos);
+	if (!match_ascii (lexer, p, ":"))
+	{
+		return pos;
+	}
+
+	closing_pos = find_ascii_in_line (lexer, p + 1, ":");
+	if (closing_pos == -1 ||
+	    closing_pos == p + 1 ||
+	    (closing_pos + 1 < lexer->n_chars &&
+	     !g_unichar_isspace (lexer->chars[closing_pos + 1])))
+	{
+		return pos;
+	}
+
+	exclude (lexer, p, closing_pos + 1);
+	return closing_pos + 1;
+}
+
+static glong
+lex_rest_inline_literal (Lexer *lexer,
+			 glong  pos)
+{
+	glong closing_pos;
+
+	if (!match_ascii (lexer, pos, "``"))
+	{
+		return pos;
+	}
+
+	closing_pos = find_ascii_in_line (lexer, pos + 2, "``");
+	if (closing_pos == -1)
+	{
+		return pos + 2;
+	}
+
+	exclude (lexer, pos, closing_pos + 2);
+	return closing_pos + 2;
+}
+
+/* :role:`text`, including domain roles like :py:func:`text`. */
+static glong
+lex_rest_role (Lexer *lexer,
+	       glong  pos)
+{
+	glong p;
+	glong closing_pos;
+
+	if (lexer->chars[pos] != ':' ||
+	    (pos > 0 && g_unichar_isalnum (lexer->chars[pos - 1])))
+	{
+		return pos;
+	}
+
+	p = pos + 1;
+	while (p < lexer->n_chars &&
+	       (g_unichar_isalnum (lexer->chars[p]) ||
+		is_ascii_char_in_set (lexer->chars[p], "-_.+:")))
+	{
+		p++;
+	}
+
+	if (p - pos < 3 ||
+	    lexer->chars[p - 1] != ':' ||
+	    !match_ascii (lexer, p, "`"))
+	{
+		return pos;
+	}
+
+	closing_pos = find_ascii_in_line (lexer, p + 1, "`");
+	if (closing_pos == -1)
+	{
+		return pos;
+	}
+
+	exclude (lexer, pos, closing_pos + 1);
+	return closing_pos + 1;
+}
+
+/* `text <target>`_: the text is prose, but not the embedded target. */
+static glong
+lex_rest_interpreted_text (Lexer *lexer,
+			   glong  pos)
+{
+	glong closing_pos;
+	glong target_start;
+
+	if (lexer->chars[pos] != '`')
+	{
+		return pos;
+	}
+
+	closing_pos = find_ascii_in_line (lexer, pos + 1, "`");
+	if (closing_pos == -1)
+	{
+		return pos + 1;
+	}
+
+	if (closing_pos > pos + 1 &&
+	    lexer->chars[closing_pos - 1] == '>')
+	{
+		for (target_start = closing_pos - 1; target_start > pos; target_start--)
+		{
+			if (lexer->chars[target_start] == '<')
+			{
+				exclude (lexer, target_start, closing_pos);
+				break;
+			}
+		}
+	}
+
+	return closing_pos + 1;
+}
+
+static glong
+lex_rest_substitution_reference (Lexer *lexer,
+				 glong  pos)
+{
+	glong closing_pos;
+
+	/* The spaces around the bars of a table are not allowed. */
+	if (lexer->chars[pos] != '|' ||
+	    pos + 1 >= lexer->n_chars ||
+	    g_unichar_isspace (lexer->chars[pos + 1]))
+	{
+		return pos;
+	}
+
+	closing_pos = find_ascii_in_line (lexer, pos + 1, "|");
+	if (closing_pos == -1 ||
+	    g_unichar_isspace (lexer->chars[closing_pos - 1]))
+	{
+		return pos;
+	}
+
+	exclude (lexer, pos, closing_pos + 1);
+	return closing_pos + 1;
+}
+
+static void
+lex_restructured_text (Lexer *lexer)
+{
+	static const LexFunc funcs[] =
+	{
+		lex_rest_explicit_markup,
+		lex_rest_field_name,
+		lex_rest_inline_literal,
+		lex_rest_role,
+		lex_rest_interpreted_text,
+		lex_rest_substitution_reference,
+		lex_url,
+	};
+
+	lex (lexer, funcs, G_N_ELEMENTS (funcs));
+}
+
+static gboolean
+range_is_excluded (const Lexer *lexer,
+		   glong        start,
+		   glong        end)
+{
+	glong pos;
+
+	for (pos = start; pos < end && pos < lexer->n_chars; pos++)
+	{
+		if (lexer->excluded[pos])
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/*
+ * _gspell_markup_lexer_filter_log_attrs:
+ * @mode: a #GspellMarkupMode.
+ * @text: the text, containing whole lines.
+ * @log_attrs: the #PangoLogAttr's of @text.
+ * @n_attrs: the number of elements of @log_attrs.
+ *
+ * Removes from @log_attrs the words that overlap non-prose text according to
+ * @mode. The @text must start at a line start and end at a line end, because
+ * the lexers need the whole line as context.
+ *
+ * Only the is_word_start fields are modified: a word is skipped by the
+ * segmentation loop of the inline checker when its start has been removed.
+ */
+void
+_gspell_markup_lexer_filter_log_attrs (GspellMarkupMode  mode,
+				       const gchar      *text,
+				       PangoLogAttr     *log_attrs,
+				       gint              n_attrs)
+{
+	Lexer lexer;
+	gint word_start;
+	gint attr_num;
+
+	g_return_if_fail (text != NULL);
+	g_return_if_fail (log_attrs != NULL);
+
+	if (mode == GSPELL_MARKUP_MODE_NONE)
+	{
+		return;
+	}
+
+	lexer.chars = g_utf8_to_ucs4_fast (text, -1, &lexer.n_chars);
+
+	if (lexer.n_chars + 1 != n_attrs)
+	{
+		g_warning ("%s(): wrong number of log attrs, got %d but expected %ld.",
+			   G_STRFUNC,
+			   n_attrs,
+			   lexer.n_chars + 1);
+		g_free (lexer.chars);
+		return;
+	}
+
+	lexer.excluded = g_new0 (gboolean, lexer.n_chars);
+
+	switch (mode)
+	{
+		case GSPELL_MARKUP_MODE_MARKDOWN:
+			lex_markdown (&lexer);
+			break;
+
+		case GSPELL_MARKUP_MODE_HTML:
+			lex_html (&lexer);
+			break;
+
+		case GSPELL_MARKUP_MODE_LATEX:
+			lex_latex (&lexer);
+			break;
+
+		case GSPELL_MARKUP_MODE_RESTRUCTURED_TEXT:
+			lex_restructured_text (&lexer);
+			break;
+
+		case GSPELL_MARKUP_MODE_NONE:
+		default:
+			g_assert_not_reached ();
+	}
+
+	/* Same word iteration as in the inline checker. */
+	word_start = -1;
+	for (attr_num = 0; attr_num < n_attrs; attr_num++)
+	{
+		if (word_start != -1 &&
+		    log_attrs[attr_num].is_word_end)
+		{
+			if (range_is_excluded (&lexer, word_start, attr_num))
+			{
+				log_attrs[word_start].is_word_start = FALSE;
+			}
+
+			word_start = -1;
+		}
+
+		if (word_start == -1 &&
+		    log_attrs[attr_num].is_word_start)
+		{
+			word_start = attr_num;
+		}
+	}
+
+	g_free (lexer.chars);
+	g_free (lexer.excluded);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,38 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSPELL_MARKUP_LEXER_H
+#define GSPELL_MARKUP_LEXER_H
+
+#include <gtk/gtk.h>
+#include "gspell-text-buffer.h"
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL
+void	_gspell_markup_lexer_filter_log_attrs	(GspellMarkupMode  mode,
+						 const gchar      *text,
+						 PangoLogAttr     *log_attrs,
+						 gint              n_attrs);
+
+G_END_DECLS
+
+#endif /* GSPELL_MARKUP_LEXER_H */
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,379 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gspell-misspelling-overlay.h"
+#include "gspell-utils.h"
+
+/* Draws squiggles under the misspelled words of a GtkTextView, without any
+ * GtkTextTag: the overlay is a child of the text window, added with
+ * gtk_text_view_add_overlay(), that covers the visible rectangle. Only the
+ * misspelled words of the visible lines are converted to positions.
+ *
+ * The misspelled words are an array of pairs of gint (start and end character
+ * offsets in the buffer), sorted and without overlaps. The array is owned and
+ * kept up-to-date by the caller, which must queue a redraw of the overlay when
+ * it changes.
+ */
+
+struct _GspellMisspellingOverlay
+{
+	GtkWidget parent;
+
+	/* Not owned, the overlay is a child of the view. */
+	GtkTextView *view;
+
+	GtkAdjustment *hadjustment;
+	GtkAdjustment *vadjustment;
+
+	GArray *ranges;
+
+	/* The visible rectangle when the overlay was positioned, in buffer
+	 * coordinates.
+	 */
+	GdkRectangle visible_rect;
+
+	GdkRGBA color;
+};
+
+typedef struct _Range Range;
+struct _Range
+{
+	gint start;
+	gint end;
+};
+
+#define SQUIGGLE_PERIOD 4.0
+#define SQUIGGLE_AMPLITUDE 1.5
+
+G_DEFINE_TYPE (GspellMisspellingOverlay, _gspell_misspelling_overlay, GTK_TYPE_WIDGET)
+
+/* Covers the visible rectangle, which changes on scroll and on resize. */
+static void
+update_position (GspellMisspellingOverlay *overlay)
+{
+	GdkRectangle visible_rect;
+
+	gtk_text_view_get_visible_rect (overlay->view, &visible_rect);
+
+	if (visible_rect.x != overlay->visible_rect.x ||
+	    visible_rect.y != overlay->visible_rect.y)
+	{
+		gtk_text_view_move_overlay (overlay->view,
+					    GTK_WIDGET (overlay),
+					    visible_rect.x,
+					    visible_rect.y);
+	}
+
+	if (visible_rect.width != overlay->visible_rect.width ||
+	    visible_rect.height != overlay->visible_rect.height)
+	{
+		gtk_widget_set_size_request (GTK_WIDGET (overlay),
+					     visible_rect.width,
+					     visible_rect.height);
+	}
+
+	overlay->visible_rect = visible_rect;
+
+	/* Other lines can be visible. */
+	gtk_widget_queue_draw (GTK_WIDGET (overlay));
+}
+
+static void
+set_adjustment (GspellMisspellingOverlay  *overlay,
+		GtkAdjustment            **adjustment_field,
+		GtkAdjustment             *adjustment)
+{
+	if (*adjustment_field == adjustment)
+	{
+		return;
+	}
+
+	if (*adjustment_field != NULL)
+	{
+		g_signal_handlers_disconnect_by_data (*adjustment_field, overlay);
+		g_clear_object (adjustment_field);
+	}
+
+	if (adjustment != NULL)
+	{
+		*adjustment_field = g_object_ref (adjustment);
+
+		g_signal_connect_object (adjustment,
+					 "value-changed",
+					 G_CALLBACK (update_position),
+					 overlay,
+					 G_CONNECT_SWAPPED);
+
+		g_signal_connect_object (adjustment,
+					 "changed",
+					 G_CALLBACK (update_position),
+					 overlay,
+					 G_CONNECT_SWAPPED);
+	}
+}
+
+static void
+adjustment_notify_cb (GtkTextView              *view,
+		      GParamSpec               *pspec,
+		      GspellMisspellingOverlay *overlay)
+{
+	set_adjustment (overlay,
+			&overlay->hadjustment,
+			gtk_scrollable_get_hadjustment (GTK_SCROLLABLE (view)));
+
+	set_adjustment (overlay,
+			&overlay->vadjustment,
+			gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)));
+
+	update_position (overlay);
+}
+
+/* Returns the index of the first range ending after @offset. */
+static guint
+find_first_range (GArray *ranges,
+		  gint    offset)
+{
+	guint low = 0;
+	guint high = ranges->len;
+
+	while (low < high)
+	{
+		guint mid = low + (high - low) / 2;
+
+		if (g_array_index (ranges, Range, mid).end <= offset)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+static void
+add_squiggle (cairo_t *cr,
+	      gdouble  x_start,
+	      gdouble  x_end,
+	      gdouble  y)
+{
+	gdouble x;
+	gboolean up = TRUE;
+
+	cairo_move_to (cr, x_start, y);
+
+	for (x = x_start + SQUIGGLE_PERIOD / 2; x < x_end; x += SQUIGGLE_PERIOD / 2)
+	{
+		cairo_line_to (cr, x, up ? y - SQUIGGLE_AMPLITUDE : y);
+		up = !up;
+	}
+
+	cairo_line_to (cr, x_end, up ? y - SQUIGGLE_AMPLITUDE : y);
+}
+
+/* Adds the squiggles of [start, end[, one per display line, in overlay
+ * coordinates.
+ */
+static void
+add_range_squiggles (GspellMisspellingOverlay *overlay,
+		     cairo_t                  *cr,
+		     GtkTextIter              *start,
+		     const GtkTextIter        *end)
+{
+	while (gtk_text_iter_compare (start, end) < 0)
+	{
+		GtkTextIter segment_end;
+		GtkTextIter last_char;
+		GdkRectangle start_location;
+		GdkRectangle last_char_location;
+
+		segment_end = *start;
+		if (!gtk_text_view_forward_display_line (overlay->view, &segment_end) ||
+		    gtk_text_iter_compare (&segment_end, end) > 0)
+		{
+			segment_end = *end;
+		}
+
+		last_char = segment_end;
+		gtk_text_iter_backward_char (&last_char);
+
+		gtk_text_view_get_iter_location (overlay->view, start, &start_location);
+		gtk_text_view_get_iter_location (overlay->view, &last_char, &last_char_location);
+
+		add_squiggle (cr,
+			      start_location.x - overlay->visible_rect.x,
+			      last_char_location.x + last_char_location.width - overlay->visible_rect.x,
+			      start_location.y + start_location.height - 1 - overlay->visible_rect.y);
+
+		*start = segment_end;
+	}
+}
+
+static void
+_gspell_misspelling_overlay_snapshot (GtkWidget   *widget,
+				      GtkSnapshot *snapshot)
+{
+	GspellMisspellingOverlay *overlay = GSPELL_MISSPELLING_OVERLAY (widget);
+	GtkTextIter iter;
+	GtkTextIter visible_end;
+	gint visible_end_offset;
+	gint iter_offset;
+	guint range_num;
+	cairo_t *cr = NULL;
+
+	if (overlay->ranges->len == 0 ||
+	    overlay->visible_rect.width <= 0 ||
+	    overlay->visible_rect.height <= 0)
+	{
+		return;
+	}
+
+	gtk_text_view_get_line_at_y (overlay->view, &iter, overlay->visible_rect.y, NULL);
+	gtk_text_view_get_line_at_y (overlay->view,
+				     &visible_end,
+				     overlay->visible_rect.y + overlay->visible_rect.height,
+				     NULL);
+	gtk_text_iter_forward_line (&visible_end);
+
+	iter_offset = gtk_text_iter_get_offset (&iter);
+	visible_end_offset = gtk_text_iter_get_offset (&visible_end);
+
+	for (range_num = find_first_range (overlay->ranges, iter_offset);
+	     range_num < overlay->ranges->len;
+	     range_num++)
+	{
+		const Range *range = &g_array_index (overlay->ranges, Range, range_num);
+		GtkTextIter range_end;
+
+		if (range->start >= visible_end_offset)
+		{
+			break;
+		}
+
+		if (cr == NULL)
+		{
+			cr = gtk_snapshot_append_cairo (snapshot,
+							&GRAPHENE_RECT_INIT (0, 0,
+									     overlay->visible_rect.width,
+									     overlay->visible_rect.height));
+			gdk_cairo_set_source_rgba (cr, &overlay->color);
+			cairo_set_line_width (cr, 1.0);
+		}
+
+		/* The iter moves forward only. */
+		gtk_text_iter_forward_chars (&iter, MAX (range->start, iter_offset) - iter_offset);
+		range_end = iter;
+		gtk_text_iter_forward_chars (&range_end, range->end - MAX (range->start, iter_offset));
+
+		add_range_squiggles (overlay, cr, &iter, &range_end);
+		iter_offset = range->end;
+	}
+
+	if (cr != NULL)
+	{
+		cairo_stroke (cr);
+		cairo_destroy (cr);
+	}
+}
+
+static void
+_gspell_misspelling_overlay_dispose (GObject *object)
+{
+	GspellMisspellingOverlay *overlay = GSPELL_MISSPELLING_OVERLAY (object);
+
+	set_adjustment (overlay, &overlay->hadjustment, NULL);
+	set_adjustment (overlay, &overlay->vadjustment, NULL);
+
+	G_OBJECT_CLASS (_gspell_misspelling_overlay_parent_class)->dispose (object);
+}
+
+static void
+_gspell_misspelling_overlay_finalize (GObject *object)
+{
+	GspellMisspellingOverlay *overlay = GSPELL_MISSPELLING_OVERLAY (object);
+
+	g_array_unref (overlay->ranges);
+
+	G_OBJECT_CLASS (_gspell_misspelling_overlay_parent_class)->finalize (object);
+}
+
+static void
+_gspell_misspelling_overlay_class_init (GspellMisspellingOverlayClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
+
+	object_class->dispose = _gspell_misspelling_overlay_dispose;
+	object_class->finalize = _gspell_misspelling_overlay_finalize;
+
+	widget_class->snapshot = _gspell_misspelling_overlay_snapshot;
+}
+
+static void
+_gspell_misspelling_overlay_init (GspellMisspellingOverlay *overlay)
+{
+	/* Purely decorative, the input goes to the view. */
+	gtk_widget_set_can_target (GTK_WIDGET (overlay), FALSE);
+	gtk_widget_set_can_focus (GTK_WIDGET (overlay), FALSE);
+
+	_gspell_utils_init_underline_rgba (&overlay->color);
+}
+
+/* Adds the overlay to @view. @ranges is the array of the misspelled words,
+ * see the description at the top of the file.
+ */
+GtkWidget *
+_gspell_misspelling_overlay_new (GtkTextView *view,
+				 GArray      *ranges)
+{
+	GspellMisspellingOverlay *overlay;
+
+	g_return_val_if_fail (GTK_IS_TEXT_VIEW (view), NULL);
+	g_return_val_if_fail (ranges != NULL, NULL);
+
+	overlay = g_object_new (GSPELL_TYPE_MISSPELLING_OVERLAY, NULL);
+	overlay->view = view;
+	overlay->ranges = g_array_ref (ranges);
+
+	gtk_text_view_add_overlay (view, GTK_WIDGET (overlay), 0, 0);
+
+	g_signal_connect_object (view,
+				 "notify::hadjustment",
+				 G_CALLBACK (adjustment_notify_cb),
+				 overlay,
+				 0);
+
+	g_signal_connect_object (view,
+				 "notify::vadjustment",
+				 G_CALLBACK (adjustment_notify_cb),
+				 overlay,
+				 0);
+
+	adjustment_notify_cb (view, NULL, overlay);
+
+	return GTK_WIDGET (overlay);
+}
+
+/* ex:set ts=8 noet: */
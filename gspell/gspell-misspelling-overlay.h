@@ -0,0 +1,42 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSPELL_MISSPELLING_OVERLAY_H
+#define GSPELL_MISSPELLING_OVERLAY_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GSPELL_TYPE_MISSPELLING_OVERLAY (_gspell_misspelling_overlay_get_type ())
+
+G_GNUC_INTERNAL
+G_DECLARE_FINAL_TYPE (GspellMisspellingOverlay, _gspell_misspelling_overlay,
+		      GSPELL, MISSPELLING_OVERLAY,
+		      GtkWidget)
+
+G_GNUC_INTERNAL
+GtkWidget *	_gspell_misspelling_overlay_new		(GtkTextView *view,
+							 GArray      *ranges);
+
+G_END_DECLS
+
+#endif /* GSPELL_MISSPELLING_OVERLAY_H */
+
+/* ex:set ts=8 noet: */
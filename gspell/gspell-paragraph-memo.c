@@ -0,0 +1,308 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gspell-paragraph-memo.h"
+
+/* A memo of the misspelled words of paragraphs (lines), keyed by a hash of
+ * their text. When a paragraph reappears (cut and paste, undo/redo, a full
+ * recheck), its misspelled words are restored without segmenting the text and
+ * calling the dictionary.
+ *
+ * The misspelled words are stored as pairs of gint, [start, end[ character
+ * offsets relative to the paragraph start. The GArrays passed to the functions
+ * must have elements of that layout.
+ *
+ * The memo is shared with the worker threads, so it is reference counted and
+ * protected by a mutex. Each entry is valid for one generation: when the
+ * verdicts can change (a word added to a dictionary, a session cleared), the
+ * memo is invalidated, and the results computed in the meantime for the
+ * previous generation are not inserted.
+ *
+ * The number of entries is bounded, the least recently used entry is evicted
+ * first.
+ */
+
+#define MAX_N_ENTRIES 4096
+
+/* FNV-1a, 64 bits. */
+#define FNV_OFFSET_BASIS G_GUINT64_CONSTANT (0xcbf29ce484222325)
+#define FNV_PRIME G_GUINT64_CONSTANT (0x100000001b3)
+
+typedef struct _Entry Entry;
+
+struct _Entry
+{
+	/* Key of the hash table. */
+	guint64 key;
+
+	/* Byte length of the paragraph, to reduce further the risk of hash
+	 * collisions.
+	 */
+	gsize length;
+
+	/* Pairs of gint. */
+	gint *offsets;
+	guint n_words;
+
+	/* Number of words checked in the paragraph, misspelled or not. */
+	guint n_checked_words;
+
+	/* In GspellParagraphMemo::lru. */
+	GList link;
+};
+
+struct _GspellParagraphMemo
+{
+	gint ref_count;
+	guint generation;
+
+	GMutex mutex;
+
+	/* guint64 key -> Entry */
+	GHashTable *entries;
+
+	/* Most recently used entry first. */
+	GQueue lru;
+};
+
+static void
+entry_free (Entry *entry)
+{
+	g_free (entry->offsets);
+	g_free (entry);
+}
+
+GspellParagraphMemo *
+_gspell_paragraph_memo_new (void)
+{
+	GspellParagraphMemo *memo;
+
+	memo = g_new0 (GspellParagraphMemo, 1);
+	memo->ref_count = 1;
+	g_mutex_init (&memo->mutex);
+	g_queue_init (&memo->lru);
+
+	memo->entries = g_hash_table_new_full (g_int64_hash,
+					       g_int64_equal,
+					       NULL,
+					       (GDestroyNotify) entry_free);
+
+	return memo;
+}
+
+GspellParagraphMemo *
+_gspell_paragraph_memo_ref (GspellParagraphMemo *memo)
+{
+	g_return_val_if_fail (memo != NULL, NULL);
+
+	g_atomic_int_inc (&memo->ref_count);
+	return memo;
+}
+
+void
+_gspell_paragraph_memo_unref (GspellParagraphMemo *memo)
+{
+	if (memo == NULL ||
+	    !g_atomic_int_dec_and_test (&memo->ref_count))
+	{
+		return;
+	}
+
+	g_hash_table_destroy (memo->entries);
+	g_mutex_clear (&memo->mutex);
+	g_free (memo);
+}
+
+guint
+_gspell_paragraph_memo_get_generation (GspellParagraphMemo *memo)
+{
+	guint generation;
+
+	g_return_val_if_fail (memo != NULL, 0);
+
+	g_mutex_lock (&memo->mutex);
+	generation = memo->generation;
+	g_mutex_unlock (&memo->mutex);
+
+	return generation;
+}
+
+/* Forgets all the entries. To call when the verdicts of the words can
+ * change.
+ */
+void
+_gspell_paragraph_memo_invalidate (GspellParagraphMemo *memo)
+{
+	g_return_if_fail (memo != NULL);
+
+	g_mutex_lock (&memo->mutex);
+
+	memo->generation++;
+	g_queue_init (&memo->lru);
+	g_hash_table_remove_all (memo->entries);
+
+	g_mutex_unlock (&memo->mutex);
+}
+
+/* Continues the hash @seed with @text. For the first call, @seed is 0. */
+guint64
+_gspell_paragraph_memo_hash (guint64      seed,
+			     const gchar *text,
+			     gsize        length)
+{
+	guint64 hash;
+	gsize i;
+
+	hash = seed != 0 ? seed : FNV_OFFSET_BASIS;
+
+	for (i = 0; i < length; i++)
+	{
+		hash ^= (guchar) text[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/* Appends the memoized misspelled words of the paragraph to
+ * @misspelled_words, shifted by @char_offset, and adds the number of checked
+ * words to @n_checked_words. Returns whether the paragraph was found.
+ */
+gboolean
+_gspell_paragraph_memo_lookup (GspellParagraphMemo *memo,
+			       guint                generation,
+			       guint64              key,
+			       gsize                length,
+			       GArray              *misspelled_words,
+			       gint                 char_offset,
+			       guint               *n_checked_words)
+{
+	Entry *entry;
+	guint i;
+
+	g_return_val_if_fail (memo != NULL, FALSE);
+	g_return_val_if_fail (g_array_get_element_size (misspelled_words) == 2 * sizeof (gint), FALSE);
+
+	g_mutex_lock (&memo->mutex);
+
+	if (generation != memo->generation)
+	{
+		g_mutex_unlock (&memo->mutex);
+		return FALSE;
+	}
+
+	entry = g_hash_table_lookup (memo->entries, &key);
+
+	if (entry == NULL || entry->length != length)
+	{
+		g_mutex_unlock (&memo->mutex);
+		return FALSE;
+	}
+
+	g_queue_unlink (&memo->lru, &entry->link);
+	g_queue_push_head_link (&memo->lru, &entry->link);
+
+	for (i = 0; i < entry->n_words; i++)
+	{
+		gint word[2];
+
+		word[0] = entry->offsets[2 * i] + char_offset;
+		word[1] = entry->offsets[2 * i + 1] + char_offset;
+		g_array_append_vals (misspelled_words, word, 1);
+	}
+
+	*n_checked_words += entry->n_checked_words;
+
+	g_mutex_unlock (&memo->mutex);
+	return TRUE;
+}
+
+/* Memoizes the misspelled words [first, len[ of @misspelled_words, which are
+ * relative to @char_offset, for a paragraph of @n_checked_words words checked
+ * during @generation.
+ */
+void
+_gspell_paragraph_memo_insert (GspellParagraphMemo *memo,
+			       guint                generation,
+			       guint64              key,
+			       gsize                length,
+			       GArray              *misspelled_words,
+			       guint                first,
+			       gint                 char_offset,
+			       guint                n_checked_words)
+{
+	Entry *entry;
+	Entry *old_entry;
+	guint i;
+
+	g_return_if_fail (memo != NULL);
+	g_return_if_fail (g_array_get_element_size (misspelled_words) == 2 * sizeof (gint));
+	g_return_if_fail (first <= misspelled_words->len);
+
+	entry = g_new0 (Entry, 1);
+	entry->key = key;
+	entry->length = length;
+	entry->link.data = entry;
+	entry->n_words = misspelled_words->len - first;
+	entry->n_checked_words = n_checked_words;
+	entry->offsets = g_new (gint, 2 * entry->n_words);
+
+	for (i = 0; i < entry->n_words; i++)
+	{
+		const gint *word = &g_array_index (misspelled_words, gint, 2 * (first + i));
+
+		entry->offsets[2 * i] = word[0] - char_offset;
+		entry->offsets[2 * i + 1] = word[1] - char_offset;
+	}
+
+	g_mutex_lock (&memo->mutex);
+
+	if (generation != memo->generation)
+	{
+		/* Computed with verdicts that are no longer valid. */
+		g_mutex_unlock (&memo->mutex);
+		entry_free (entry);
+		return;
+	}
+
+	old_entry = g_hash_table_lookup (memo->entries, &key);
+
+	if (old_entry != NULL)
+	{
+		g_queue_unlink (&memo->lru, &old_entry->link);
+		g_hash_table_remove (memo->entries, &key);
+	}
+	else if (g_hash_table_size (memo->entries) >= MAX_N_ENTRIES)
+	{
+		GList *oldest = g_queue_pop_tail_link (&memo->lru);
+
+		g_hash_table_remove (memo->entries, &((Entry *) oldest->data)->key);
+	}
+
+	g_hash_table_insert (memo->entries, &entry->key, entry);
+	g_queue_push_head_link (&memo->lru, &entry->link);
+
+	g_mutex_unlock (&memo->mutex);
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,74 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSPELL_PARAGRAPH_MEMO_H
+#define GSPELL_PARAGRAPH_MEMO_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GspellParagraphMemo GspellParagraphMemo;
+
+G_GNUC_INTERNAL
+GspellParagraphMemo *
+		_gspell_paragraph_memo_new		(void);
+
+G_GNUC_INTERNAL
+GspellParagraphMemo *
+		_gspell_paragraph_memo_ref		(GspellParagraphMemo *memo);
+
+G_GNUC_INTERNAL
+void		_gspell_paragraph_memo_unref		(GspellParagraphMemo *memo);
+
+G_GNUC_INTERNAL
+guint		_gspell_paragraph_memo_get_generation	(GspellParagraphMemo *memo);
+
+G_GNUC_INTERNAL
+void		_gspell_paragraph_memo_invalidate	(GspellParagraphMemo *memo);
+
+G_GNUC_INTERNAL
+guint64		_gspell_paragraph_memo_hash		(guint64              seed,
+							 const gchar         *text,
+							 gsize                length);
+
+G_GNUC_INTERNAL
+gboolean	_gspell_paragraph_memo_lookup		(GspellParagraphMemo *memo,
+							 guint                generation,
+							 guint64              key,
+							 gsize                length,
+							 GArray              *misspelled_words,
+							 gint                 char_offset,
+							 guint               *n_checked_words);
+
+G_GNUC_INTERNAL
+void		_gspell_paragraph_memo_insert		(GspellParagraphMemo *memo,
+							 guint                generation,
+							 guint64              key,
+							 gsize                length,
+							 GArray              *misspelled_words,
+							 guint                first,
+							 gint                 char_offset,
+							 guint                n_checked_words);
+
+G_END_DECLS
+
+#endif /* GSPELL_PARAGRAPH_MEMO_H */
+
+/* ex:set ts=8 noet: */
@@ -1,4 +1,6 @@
-/* Do not edit: this file is generated from https://gitlab.gnome.org/GNOME/gtksourceview/raw/master/gtksourceview/gtksourceregion.c */
+/* Originally generated from https://gitlab.gnome.org/GNOME/gtksourceview/raw/master/gtksourceview/gtksourceregion.c,
+ * now maintained in gspell: do not regenerate it with update-sourceregion.sh.
+ */
 
 /*
  * This file is part of GtkSourceView
@@ -26,23 +28,27 @@
 
 /*
  * GspellRegion:
- * 
+ *
  * Region utility.
  *
  * A `GspellRegion` permits to store a group of subregions of a
  * [class@Gtk.TextBuffer]. `GspellRegion` stores the subregions with pairs of
- * [class@Gtk.TextMark]'s, so the region is still valid after insertions and deletions
- * in the [class@Gtk.TextBuffer].
+ * character offsets, it doesn't create any [class@Gtk.TextMark] in the buffer.
+ * To keep the region valid after insertions and deletions in the
+ * [class@Gtk.TextBuffer], the owner of the region must report them with
+ * _gspell_region_insert_text() and _gspell_region_delete_text(), typically from
+ * the [signal@Gtk.TextBuffer::insert-text] and
+ * [signal@Gtk.TextBuffer::delete-range] signal handlers. The edits are
+ * recorded in a log, and are applied to the offsets only when the region is
+ * queried or modified.
  *
- * The [class@Gtk.TextMark] for the start of a subregion has a left gravity, while the
- * [class@Gtk.TextMark] for the end of a subregion has a right gravity.
+ * The offsets behave like marks: the start of a subregion has a left gravity,
+ * while the end of a subregion has a right gravity. A subregion that becomes
+ * empty due to a text deletion is removed.
  *
  * The typical use-case of `GspellRegion` is to scan a [class@Gtk.TextBuffer] chunk by
  * chunk, not the whole buffer at once to not block the user interface. The
- * `GspellRegion` represents in that case the remaining region to scan. You
- * can listen to the [signal@Gtk.TextBuffer::insert-text] and
- * [signal@Gtk.TextBuffer::delete-range] signals to update the `GspellRegion`
- * accordingly.
+ * `GspellRegion` represents in that case the remaining region to scan.
  *
  * To iterate through the subregions, you need to use a [struct@RegionIter],
  * for example:
@@ -69,10 +75,25 @@
  *         _gspell_region_iter_next (&region_iter);
  * }
  * ```
+ *
+ * To only read the character offsets of the subregions, possibly in a range,
+ * a [struct@RegionView] is lighter: it borrows the subregions of the region,
+ * and doesn't create any #GtkTextIter.
+ * ```c
+ * GspellRegionView view;
+ * gint start;
+ * gint end;
+ *
+ * _gspell_region_view_init (&view, region, range_start, range_end);
+ *
+ * while (_gspell_region_view_next (&view, &start, &end))
+ * {
+ *         // [start, end] is in [range_start, range_end].
+ * }
+ * ```
  */
 
-/* With the gravities of the GtkTextMarks, it is possible for subregions to
- * become interlaced:
+/* With the gravities, it is possible for subregions to become interlaced:
  * Buffer content:
  *   "hello world"
  * Add two subregions:
@@ -82,8 +103,8 @@
  * Undo:
  *   "[hello[ ]world]"
  *
- * FIXME: when iterating through the subregions, it should simplify them first.
- * I don't know if it's done (swilmet).
+ * The starts and the ends of the subregions both stay sorted though, which is
+ * what the binary searches need.
  */
 
 #undef ENABLE_DEBUG
@@ -97,34 +118,78 @@
 #define DEBUG(x)
 #endif
 
+/* When the log of edits reaches this size, it is applied directly. */
+#define MAX_PENDING_EDITS 64
+
 typedef struct _GspellRegionPrivate GspellRegionPrivate;
 typedef struct _Subregion Subregion;
+typedef struct _Edit Edit;
 typedef struct _GspellRegionIterReal GspellRegionIterReal;
+typedef struct _GspellRegionViewReal GspellRegionViewReal;
 
 struct _GspellRegionPrivate
 {
 	/* Weak pointer to the buffer. */
 	GtkTextBuffer *buffer;
 
-	/* List of sorted 'Subregion*' */
-	GList *subregions;
+	/* Array of sorted 'Subregion', so that a subregion can be found with
+	 * a binary search.
+	 */
+	GArray *subregions;
+
+	/* Array of 'Edit', the buffer edits not yet applied to the
+	 * subregions, in chronological order.
+	 */
+	GArray *pending_edits;
+
+	/* Array of 'Subregion', the result of the operations between two
+	 * regions, swapped with @subregions afterwards. It is kept to reuse
+	 * its memory.
+	 */
+	GArray *scratch;
 
 	guint32 timestamp;
 };
 
+/* Character offsets, valid once the pending edits are applied. */
 struct _Subregion
 {
-	GtkTextMark *start;
-	GtkTextMark *end;
+	gint start;
+	gint end;
+};
+
+/* An insertion of @n_chars characters at @offset if @n_chars is positive, or a
+ * deletion of -@n_chars characters from @offset if @n_chars is negative.
+ */
+struct _Edit
+{
+	gint offset;
+	gint n_chars;
 };
 
 struct _GspellRegionIterReal
 {
 	GspellRegion *region;
 	guint32 region_timestamp;
-	GList *subregions;
+	guint subregion_index;
 };
 
+struct _GspellRegionViewReal
+{
+	GspellRegion *region;
+	guint32 region_timestamp;
+
+	/* The subregions in [subregion_index, end_index[ remain to be
+	 * returned, clipped to [start, end].
+	 */
+	guint subregion_index;
+	guint end_index;
+	gint start;
+	gint end;
+};
+
+G_STATIC_ASSERT (sizeof (GspellRegionViewReal) == sizeof (GspellRegionView));
+
 enum
 {
 	PROP_0,
@@ -148,71 +213,410 @@ print_region (GspellRegion *region)
 }
 #endif
 
-/* Find and return a subregion node which contains the given text
- * iter.  If left_side is TRUE, return the subregion which contains
- * the text iter or which is the leftmost; else return the rightmost
- * subregion.
+static inline Subregion *
+get_subregion (GspellRegionPrivate *priv,
+	       guint                index)
+{
+	return &g_array_index (priv->subregions, Subregion, index);
+}
+
+/* Find and return the index of a subregion which contains the given offset,
+ * searching from the subregion at the index @begin. If @leftmost is FALSE,
+ * return the first subregion which contains the offset or which is after it,
+ * or the number of subregions if there is none. If @leftmost is TRUE, return
+ * the last subregion which contains the offset or which is before it, or
+ * @begin - 1 if there is none.
+ *
+ * The subregions are sorted, so it is a binary search.
  */
-static GList *
-find_nearest_subregion (GspellRegion   *region,
-			const GtkTextIter *iter,
-			GList             *begin,
-			gboolean           leftmost,
-			gboolean           include_edges)
+static gint
+find_nearest_subregion (GspellRegionPrivate *priv,
+			gint                 offset,
+			guint                begin,
+			gboolean             leftmost,
+			gboolean             include_edges)
 {
-	GspellRegionPrivate *priv = _gspell_region_get_instance_private (region);
-	GList *retval;
-	GList *l;
+	guint low;
+	guint high;
 
-	g_assert (iter != NULL);
+	low = begin;
+	high = priv->subregions->len;
 
-	if (begin == NULL)
+	/* Find the first subregion for which the search must not go further
+	 * to the right.
+	 */
+	while (low < high)
 	{
-		begin = priv->subregions;
+		guint middle = low + (high - low) / 2;
+		Subregion *sr = get_subregion (priv, middle);
+		gboolean go_right;
+
+		if (!leftmost)
+		{
+			go_right = !(offset < sr->end || (offset == sr->end && include_edges));
+		}
+		else
+		{
+			go_right = offset > sr->start || (offset == sr->start && include_edges);
+		}
+
+		if (go_right)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
 	}
 
-	if (begin != NULL)
+	return leftmost ? (gint) low - 1 : (gint) low;
+}
+
+static gint
+apply_edit_to_offset (const Edit *edit,
+		      gint        offset,
+		      gboolean    left_gravity)
+{
+	if (edit->n_chars > 0)
 	{
-		retval = begin->prev;
+		if (offset > edit->offset ||
+		    (offset == edit->offset && !left_gravity))
+		{
+			return offset + edit->n_chars;
+		}
+
+		return offset;
 	}
-	else
+
+	if (offset <= edit->offset)
 	{
-		retval = NULL;
+		return offset;
 	}
 
-	for (l = begin; l != NULL; l = l->next)
+	if (offset >= edit->offset - edit->n_chars)
 	{
-		GtkTextIter sr_iter;
-		Subregion *sr = l->data;
-		gint cmp;
+		return offset + edit->n_chars;
+	}
 
-		if (!leftmost)
+	return edit->offset;
+}
+
+/* Shifts the offsets of the subregions through the log of edits. The
+ * subregions before an edit are not affected by it, so each edit begins with
+ * a binary search.
+ */
+static void
+apply_pending_edits (GspellRegionPrivate *priv)
+{
+	gboolean subregion_emptied = FALSE;
+	guint edit_num;
+
+	for (edit_num = 0; edit_num < priv->pending_edits->len; edit_num++)
+	{
+		const Edit *edit = &g_array_index (priv->pending_edits, Edit, edit_num);
+		guint i;
+
+		i = find_nearest_subregion (priv, edit->offset, 0, FALSE, TRUE);
+
+		for (; i < priv->subregions->len; i++)
 		{
-			gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_iter, sr->end);
-			cmp = gtk_text_iter_compare (iter, &sr_iter);
-			if (cmp < 0 || (cmp == 0 && include_edges))
+			Subregion *sr = get_subregion (priv, i);
+
+			sr->start = apply_edit_to_offset (edit, sr->start, TRUE);
+			sr->end = apply_edit_to_offset (edit, sr->end, FALSE);
+
+			if (sr->start == sr->end)
 			{
-				retval = l;
-				break;
+				subregion_emptied = TRUE;
 			}
+		}
+	}
+
+	g_array_set_size (priv->pending_edits, 0);
+
+	if (subregion_emptied)
+	{
+		guint n_kept = 0;
+		guint i;
 
+		/* Compact the array in one pass. */
+		for (i = 0; i < priv->subregions->len; i++)
+		{
+			Subregion *sr = get_subregion (priv, i);
+
+			if (sr->start != sr->end)
+			{
+				*get_subregion (priv, n_kept) = *sr;
+				n_kept++;
+			}
+		}
+
+		g_array_set_size (priv->subregions, n_kept);
+		priv->timestamp++;
+	}
+}
+
+/* Returns the private struct with up-to-date offsets, or NULL if the buffer
+ * has been finalized.
+ */
+static GspellRegionPrivate *
+get_updated_priv (GspellRegion *region)
+{
+	GspellRegionPrivate *priv = _gspell_region_get_instance_private (region);
+
+	if (priv->buffer == NULL)
+	{
+		return NULL;
+	}
+
+	if (priv->pending_edits->len > 0)
+	{
+		apply_pending_edits (priv);
+	}
+
+	return priv;
+}
+
+static void
+add_edit (GspellRegionPrivate *priv,
+	  gint                 offset,
+	  gint                 n_chars)
+{
+	Edit edit;
+
+	/* Without subregions, there is nothing to shift. */
+	if (priv->subregions->len == 0)
+	{
+		return;
+	}
+
+	/* Merge with the previous edit when possible, so that typing or
+	 * erasing a word is recorded as one edit.
+	 */
+	if (priv->pending_edits->len > 0)
+	{
+		Edit *last = &g_array_index (priv->pending_edits, Edit, priv->pending_edits->len - 1);
+
+		if (n_chars > 0 &&
+		    last->n_chars > 0 &&
+		    offset == last->offset + last->n_chars)
+		{
+			/* Text inserted just after the previous insertion. */
+			last->n_chars += n_chars;
+			return;
+		}
+
+		if (n_chars < 0 &&
+		    last->n_chars > 0 &&
+		    offset >= last->offset &&
+		    offset - n_chars <= last->offset + last->n_chars)
+		{
+			/* Text deleted inside the previous insertion. */
+			last->n_chars += n_chars;
+
+			if (last->n_chars == 0)
+			{
+				g_array_set_size (priv->pending_edits, priv->pending_edits->len - 1);
+			}
+
+			return;
+		}
+
+		if (n_chars < 0 &&
+		    last->n_chars < 0 &&
+		    (offset == last->offset || offset - n_chars == last->offset))
+		{
+			/* Text deleted just after (Delete key) or just before
+			 * (Backspace key) the previous deletion.
+			 */
+			last->offset = offset;
+			last->n_chars += n_chars;
+			return;
+		}
+	}
+
+	edit.offset = offset;
+	edit.n_chars = n_chars;
+	g_array_append_val (priv->pending_edits, edit);
+
+	if (priv->pending_edits->len >= MAX_PENDING_EDITS)
+	{
+		apply_pending_edits (priv);
+	}
+}
+
+/* The operations between two sorted arrays of 'Subregion' walk both arrays
+ * once, and append the result to @result.
+ */
+static void
+union_subregions (GArray *a,
+		  GArray *b,
+		  GArray *result)
+{
+	guint a_num = 0;
+	guint b_num = 0;
+
+	while (a_num < a->len || b_num < b->len)
+	{
+		const Subregion *next;
+
+		if (b_num == b->len ||
+		    (a_num < a->len &&
+		     g_array_index (a, Subregion, a_num).start <= g_array_index (b, Subregion, b_num).start))
+		{
+			next = &g_array_index (a, Subregion, a_num++);
 		}
 		else
 		{
-			gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_iter, sr->start);
-			cmp = gtk_text_iter_compare (iter, &sr_iter);
-			if (cmp > 0 || (cmp == 0 && include_edges))
+			next = &g_array_index (b, Subregion, b_num++);
+		}
+
+		/* Merge the overlapping or adjacent subregions, like
+		 * add_subregion_offsets().
+		 */
+		if (result->len > 0)
+		{
+			Subregion *last = &g_array_index (result, Subregion, result->len - 1);
+
+			if (next->start <= last->end)
 			{
-				retval = l;
+				last->end = MAX (last->end, next->end);
+				continue;
 			}
-			else
+		}
+
+		g_array_append_vals (result, next, 1);
+	}
+}
+
+static void
+subtract_subregions (GArray *a,
+		     GArray *b,
+		     GArray *result)
+{
+	guint a_num;
+	guint b_num = 0;
+
+	for (a_num = 0; a_num < a->len; a_num++)
+	{
+		const Subregion *sr = &g_array_index (a, Subregion, a_num);
+		gint start = sr->start;
+		gint end = sr->end;
+		guint i;
+
+		/* Skip the subregions of @b entirely before. The next
+		 * subregions of @a are further, so they are skipped only once.
+		 */
+		while (b_num < b->len &&
+		       g_array_index (b, Subregion, b_num).end <= start)
+		{
+			b_num++;
+		}
+
+		for (i = b_num; i < b->len && start < end; i++)
+		{
+			const Subregion *to_subtract = &g_array_index (b, Subregion, i);
+
+			if (to_subtract->start >= end)
 			{
 				break;
 			}
+
+			if (to_subtract->start > start)
+			{
+				Subregion piece;
+
+				piece.start = start;
+				piece.end = to_subtract->start;
+				g_array_append_val (result, piece);
+			}
+
+			start = MAX (start, to_subtract->end);
+		}
+
+		if (start < end)
+		{
+			Subregion piece;
+
+			piece.start = start;
+			piece.end = end;
+			g_array_append_val (result, piece);
 		}
 	}
+}
+
+static void
+intersect_subregions (GArray *a,
+		      GArray *b,
+		      GArray *result)
+{
+	guint a_num = 0;
+	guint b_num = 0;
+
+	while (a_num < a->len && b_num < b->len)
+	{
+		const Subregion *a_sr = &g_array_index (a, Subregion, a_num);
+		const Subregion *b_sr = &g_array_index (b, Subregion, b_num);
+		Subregion piece;
+
+		piece.start = MAX (a_sr->start, b_sr->start);
+		piece.end = MIN (a_sr->end, b_sr->end);
+
+		if (piece.start < piece.end)
+		{
+			g_array_append_val (result, piece);
+		}
 
-	return retval;
+		/* Go forward in the array of the subregion ending first. */
+		if (a_sr->end < b_sr->end)
+		{
+			a_num++;
+		}
+		else
+		{
+			b_num++;
+		}
+	}
+}
+
+/* To call after filling priv->scratch with the new subregions. */
+static void
+swap_scratch (GspellRegionPrivate *priv)
+{
+	GArray *old_subregions = priv->subregions;
+
+	priv->subregions = priv->scratch;
+	priv->scratch = old_subregions;
+	g_array_set_size (priv->scratch, 0);
+
+	priv->timestamp++;
+}
+
+/* Returns the private structs with up-to-date offsets of two regions of the
+ * same buffer, or FALSE if they can't be combined.
+ */
+static gboolean
+get_updated_privs (GspellRegion         *region1,
+		   GspellRegion         *region2,
+		   GspellRegionPrivate **priv1,
+		   GspellRegionPrivate **priv2)
+{
+	GtkTextBuffer *region1_buffer;
+	GtkTextBuffer *region2_buffer;
+
+	region1_buffer = _gspell_region_get_buffer (region1);
+	region2_buffer = _gspell_region_get_buffer (region2);
+	g_return_val_if_fail (region1_buffer == region2_buffer, FALSE);
+
+	if (region1_buffer == NULL)
+	{
+		return FALSE;
+	}
+
+	*priv1 = get_updated_priv (region1);
+	*priv2 = get_updated_priv (region2);
+	return TRUE;
 }
 
 static void
@@ -263,19 +667,9 @@ _gspell_region_dispose (GObject *object)
 {
 	GspellRegionPrivate *priv = _gspell_region_get_instance_private (GSPELL_REGION (object));
 
-	while (priv->subregions != NULL)
-	{
-		Subregion *sr = priv->subregions->data;
-
-		if (priv->buffer != NULL)
-		{
-			gtk_text_buffer_delete_mark (priv->buffer, sr->start);
-			gtk_text_buffer_delete_mark (priv->buffer, sr->end);
-		}
-
-		g_slice_free (Subregion, sr);
-		priv->subregions = g_list_delete_link (priv->subregions, priv->subregions);
-	}
+	g_array_set_size (priv->subregions, 0);
+	g_array_set_size (priv->pending_edits, 0);
+	g_array_set_size (priv->scratch, 0);
 
 	if (priv->buffer != NULL)
 	{
@@ -288,6 +682,18 @@ _gspell_region_dispose (GObject *object)
 	G_OBJECT_CLASS (_gspell_region_parent_class)->dispose (object);
 }
 
+static void
+_gspell_region_finalize (GObject *object)
+{
+	GspellRegionPrivate *priv = _gspell_region_get_instance_private (GSPELL_REGION (object));
+
+	g_array_unref (priv->subregions);
+	g_array_unref (priv->pending_edits);
+	g_array_unref (priv->scratch);
+
+	G_OBJECT_CLASS (_gspell_region_parent_class)->finalize (object);
+}
+
 static void
 _gspell_region_class_init (GspellRegionClass *klass)
 {
@@ -296,6 +702,7 @@ _gspell_region_class_init (GspellRegionClass *klass)
 	object_class->get_property = _gspell_region_get_property;
 	object_class->set_property = _gspell_region_set_property;
 	object_class->dispose = _gspell_region_dispose;
+	object_class->finalize = _gspell_region_finalize;
 
 	/*
 	 * GspellRegion:buffer:
@@ -318,6 +725,11 @@ _gspell_region_class_init (GspellRegionClass *klass)
 static void
 _gspell_region_init (GspellRegion *region)
 {
+	GspellRegionPrivate *priv = _gspell_region_get_instance_private (region);
+
+	priv->subregions = g_array_new (FALSE, FALSE, sizeof (Subregion));
+	priv->pending_edits = g_array_new (FALSE, FALSE, sizeof (Edit));
+	priv->scratch = g_array_new (FALSE, FALSE, sizeof (Subregion));
 }
 
 /*
@@ -353,392 +765,276 @@ _gspell_region_get_buffer (GspellRegion *region)
 	return priv->buffer;
 }
 
-static void
-_gspell_region_clear_zero_length_subregions (GspellRegion *region)
+/*
+ * _gspell_region_insert_text:
+ * @region: a #GspellRegion.
+ * @offset: the character offset where the text is inserted.
+ * @n_chars: the number of inserted characters.
+ *
+ * Reports a text insertion in the buffer, to shift the subregions accordingly.
+ * It must be called before querying or modifying @region with the offsets
+ * after the insertion.
+ */
+void
+_gspell_region_insert_text (GspellRegion *region,
+			    gint          offset,
+			    gint          n_chars)
 {
-	GspellRegionPrivate *priv = _gspell_region_get_instance_private (region);
-	GList *node;
-
-	node = priv->subregions;
-	while (node != NULL)
-	{
-		Subregion *sr = node->data;
-		GtkTextIter start;
-		GtkTextIter end;
-
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &start, sr->start);
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &end, sr->end);
+	GspellRegionPrivate *priv;
 
-		if (gtk_text_iter_equal (&start, &end))
-		{
-			gtk_text_buffer_delete_mark (priv->buffer, sr->start);
-			gtk_text_buffer_delete_mark (priv->buffer, sr->end);
-			g_slice_free (Subregion, sr);
+	g_return_if_fail (GSPELL_IS_REGION (region));
+	g_return_if_fail (offset >= 0);
+	g_return_if_fail (n_chars >= 0);
 
-			if (node == priv->subregions)
-			{
-				priv->subregions = node = g_list_delete_link (node, node);
-			}
-			else
-			{
-				node = g_list_delete_link (node, node);
-			}
+	priv = _gspell_region_get_instance_private (region);
 
-			priv->timestamp++;
-		}
-		else
-		{
-			node = node->next;
-		}
+	if (n_chars > 0)
+	{
+		add_edit (priv, offset, n_chars);
 	}
 }
 
 /*
- * _gspell_region_add_subregion:
+ * _gspell_region_delete_text:
  * @region: a #GspellRegion.
- * @_start: the start of the subregion.
- * @_end: the end of the subregion.
+ * @start_offset: the start of the deleted text.
+ * @end_offset: the end of the deleted text.
  *
- * Adds the subregion delimited by @_start and @_end to @region.
+ * Reports a text deletion in the buffer, to shift the subregions accordingly.
+ * Like for _gspell_region_insert_text(), @region must not be used in the
+ * meantime with the offsets after the deletion.
  */
 void
-_gspell_region_add_subregion (GspellRegion   *region,
-				 const GtkTextIter *_start,
-				 const GtkTextIter *_end)
+_gspell_region_delete_text (GspellRegion *region,
+			    gint          start_offset,
+			    gint          end_offset)
 {
 	GspellRegionPrivate *priv;
-	GList *start_node;
-	GList *end_node;
-	GtkTextIter start;
-	GtkTextIter end;
 
 	g_return_if_fail (GSPELL_IS_REGION (region));
-	g_return_if_fail (_start != NULL);
-	g_return_if_fail (_end != NULL);
+	g_return_if_fail (0 <= start_offset && start_offset <= end_offset);
 
 	priv = _gspell_region_get_instance_private (region);
 
-	if (priv->buffer == NULL)
+	if (start_offset < end_offset)
 	{
-		return;
+		add_edit (priv, start_offset, start_offset - end_offset);
 	}
+}
 
-	start = *_start;
-	end = *_end;
-
-	DEBUG (g_print ("---\n"));
-	DEBUG (print_region (region));
-	DEBUG (g_message ("region_add (%d, %d)",
-			  gtk_text_iter_get_offset (&start),
-			  gtk_text_iter_get_offset (&end)));
+static void
+add_subregion_offsets (GspellRegionPrivate *priv,
+		       gint                 start,
+		       gint                 end)
+{
+	gint start_index;
+	gint end_index;
 
-	gtk_text_iter_order (&start, &end);
+	DEBUG (g_message ("region_add (%d, %d)", start, end));
 
 	/* Don't add zero-length regions. */
-	if (gtk_text_iter_equal (&start, &end))
+	if (start == end)
 	{
 		return;
 	}
 
 	/* Find bounding subregions. */
-	start_node = find_nearest_subregion (region, &start, NULL, FALSE, TRUE);
-	end_node = find_nearest_subregion (region, &end, start_node, TRUE, TRUE);
+	start_index = find_nearest_subregion (priv, start, 0, FALSE, TRUE);
+	end_index = find_nearest_subregion (priv, end, start_index, TRUE, TRUE);
 
-	if (start_node == NULL || end_node == NULL || end_node == start_node->prev)
+	if (start_index == (gint) priv->subregions->len || end_index < start_index)
 	{
-		/* Create the new subregion. */
-		Subregion *sr = g_slice_new0 (Subregion);
-		sr->start = gtk_text_buffer_create_mark (priv->buffer, NULL, &start, TRUE);
-		sr->end = gtk_text_buffer_create_mark (priv->buffer, NULL, &end, FALSE);
+		/* Create the new subregion, before the start subregion, or
+		 * at the end if there is none.
+		 */
+		Subregion sr;
 
-		if (start_node == NULL)
-		{
-			/* Append the new region. */
-			priv->subregions = g_list_append (priv->subregions, sr);
-		}
-		else if (end_node == NULL)
-		{
-			/* Prepend the new region. */
-			priv->subregions = g_list_prepend (priv->subregions, sr);
-		}
-		else
-		{
-			/* We are in the middle of two subregions. */
-			priv->subregions = g_list_insert_before (priv->subregions, start_node, sr);
-		}
+		sr.start = start;
+		sr.end = end;
+		g_array_insert_val (priv->subregions, start_index, sr);
 	}
 	else
 	{
-		GtkTextIter iter;
-		Subregion *sr = start_node->data;
-
-		if (start_node != end_node)
-		{
-			/* We need to merge some subregions. */
-			GList *l = start_node->next;
-			Subregion *q;
-
-			gtk_text_buffer_delete_mark (priv->buffer, sr->end);
+		Subregion *sr = get_subregion (priv, start_index);
 
-			while (l != end_node)
-			{
-				q = l->data;
-				gtk_text_buffer_delete_mark (priv->buffer, q->start);
-				gtk_text_buffer_delete_mark (priv->buffer, q->end);
-				g_slice_free (Subregion, q);
-				l = g_list_delete_link (l, l);
-			}
-
-			q = l->data;
-			gtk_text_buffer_delete_mark (priv->buffer, q->start);
-			sr->end = q->end;
-			g_slice_free (Subregion, q);
-			l = g_list_delete_link (l, l);
-		}
-
-		/* Now move marks if that action expands the region. */
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &iter, sr->start);
-		if (gtk_text_iter_compare (&iter, &start) > 0)
-		{
-			gtk_text_buffer_move_mark (priv->buffer, sr->start, &start);
-		}
+		/* Merge the subregions in [start_index, end_index]. */
+		sr->start = MIN (sr->start, start);
+		sr->end = MAX (get_subregion (priv, end_index)->end, end);
 
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &iter, sr->end);
-		if (gtk_text_iter_compare (&iter, &end) < 0)
+		if (start_index < end_index)
 		{
-			gtk_text_buffer_move_mark (priv->buffer, sr->end, &end);
+			g_array_remove_range (priv->subregions,
+					      start_index + 1,
+					      end_index - start_index);
 		}
 	}
 
 	priv->timestamp++;
-
-	DEBUG (print_region (region));
 }
 
 /*
- * _gspell_region_add_region:
+ * _gspell_region_add_subregion:
  * @region: a #GspellRegion.
- * @region_to_add: (nullable): the #GspellRegion to add to @region, or %NULL.
+ * @_start: the start of the subregion.
+ * @_end: the end of the subregion.
  *
- * Adds @region_to_add to @region. 
- * 
- * @region_to_add is not modified.
+ * Adds the subregion delimited by @_start and @_end to @region.
  */
 void
-_gspell_region_add_region (GspellRegion *region,
-			      GspellRegion *region_to_add)
+_gspell_region_add_subregion (GspellRegion   *region,
+				 const GtkTextIter *_start,
+				 const GtkTextIter *_end)
 {
-	GspellRegionIter iter;
-	GtkTextBuffer *region_buffer;
-	GtkTextBuffer *region_to_add_buffer;
+	GspellRegionPrivate *priv;
+	GtkTextIter start;
+	GtkTextIter end;
 
 	g_return_if_fail (GSPELL_IS_REGION (region));
-	g_return_if_fail (region_to_add == NULL || GSPELL_IS_REGION (region_to_add));
-
-	if (region_to_add == NULL)
-	{
-		return;
-	}
+	g_return_if_fail (_start != NULL);
+	g_return_if_fail (_end != NULL);
 
-	region_buffer = _gspell_region_get_buffer (region);
-	region_to_add_buffer = _gspell_region_get_buffer (region_to_add);
-	g_return_if_fail (region_buffer == region_to_add_buffer);
+	priv = get_updated_priv (region);
 
-	if (region_buffer == NULL)
+	if (priv == NULL)
 	{
 		return;
 	}
 
-	_gspell_region_get_start_region_iter (region_to_add, &iter);
+	start = *_start;
+	end = *_end;
 
-	while (!_gspell_region_iter_is_end (&iter))
-	{
-		GtkTextIter subregion_start;
-		GtkTextIter subregion_end;
+	DEBUG (g_print ("---\n"));
+	DEBUG (print_region (region));
 
-		if (!_gspell_region_iter_get_subregion (&iter,
-							   &subregion_start,
-							   &subregion_end))
-		{
-			break;
-		}
+	gtk_text_iter_order (&start, &end);
 
-		_gspell_region_add_subregion (region,
-						 &subregion_start,
-						 &subregion_end);
+	add_subregion_offsets (priv,
+			       gtk_text_iter_get_offset (&start),
+			       gtk_text_iter_get_offset (&end));
 
-		_gspell_region_iter_next (&iter);
-	}
+	DEBUG (print_region (region));
 }
 
 /*
- * _gspell_region_subtract_subregion:
+ * _gspell_region_add_region:
  * @region: a #GspellRegion.
- * @_start: the start of the subregion.
- * @_end: the end of the subregion.
+ * @region_to_add: (nullable): the #GspellRegion to add to @region, or %NULL.
  *
- * Subtracts the subregion delimited by @_start and @_end from @region.
+ * Adds @region_to_add to @region.
+ *
+ * @region_to_add is not modified.
  */
 void
-_gspell_region_subtract_subregion (GspellRegion   *region,
-				      const GtkTextIter *_start,
-				      const GtkTextIter *_end)
+_gspell_region_add_region (GspellRegion *region,
+			      GspellRegion *region_to_add)
 {
 	GspellRegionPrivate *priv;
-	GList *start_node;
-	GList *end_node;
-	GList *node;
-	GtkTextIter sr_start_iter;
-	GtkTextIter sr_end_iter;
-	gboolean done;
-	gboolean start_is_outside;
-	gboolean end_is_outside;
-	Subregion *sr;
-	GtkTextIter start;
-	GtkTextIter end;
+	GspellRegionPrivate *priv_to_add;
 
 	g_return_if_fail (GSPELL_IS_REGION (region));
-	g_return_if_fail (_start != NULL);
-	g_return_if_fail (_end != NULL);
-
-	priv = _gspell_region_get_instance_private (region);
+	g_return_if_fail (region_to_add == NULL || GSPELL_IS_REGION (region_to_add));
 
-	if (priv->buffer == NULL)
+	if (region_to_add == NULL ||
+	    !get_updated_privs (region, region_to_add, &priv, &priv_to_add) ||
+	    priv_to_add->subregions->len == 0)
 	{
 		return;
 	}
 
-	start = *_start;
-	end = *_end;
+	union_subregions (priv->subregions, priv_to_add->subregions, priv->scratch);
+	swap_scratch (priv);
+}
 
-	DEBUG (g_print ("---\n"));
-	DEBUG (print_region (region));
-	DEBUG (g_message ("region_substract (%d, %d)",
-			  gtk_text_iter_get_offset (&start),
-			  gtk_text_iter_get_offset (&end)));
+static void
+subtract_subregion_offsets (GspellRegionPrivate *priv,
+			    gint                 start,
+			    gint                 end)
+{
+	gint start_index;
+	gint end_index;
+	Subregion pieces[2];
+	guint n_pieces = 0;
 
-	gtk_text_iter_order (&start, &end);
+	DEBUG (g_message ("region_substract (%d, %d)", start, end));
 
 	/* Find bounding subregions. */
-	start_node = find_nearest_subregion (region, &start, NULL, FALSE, FALSE);
-	end_node = find_nearest_subregion (region, &end, start_node, TRUE, FALSE);
+	start_index = find_nearest_subregion (priv, start, 0, FALSE, FALSE);
+	end_index = find_nearest_subregion (priv, end, start_index, TRUE, FALSE);
 
 	/* Easy case first. */
-	if (start_node == NULL || end_node == NULL || end_node == start_node->prev)
+	if (start_index == (gint) priv->subregions->len || end_index < start_index)
 	{
 		return;
 	}
 
-	/* Deal with the start point. */
-	start_is_outside = end_is_outside = FALSE;
-
-	sr = start_node->data;
-	gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_start_iter, sr->start);
-	gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_end_iter, sr->end);
-
-	if (gtk_text_iter_in_range (&start, &sr_start_iter, &sr_end_iter) &&
-	    !gtk_text_iter_equal (&start, &sr_start_iter))
+	/* Keep what is outside [start, end] in the first and last subregions,
+	 * which are the same one if it needs to be split.
+	 */
+	if (get_subregion (priv, start_index)->start < start)
 	{
-		/* The starting point is inside the first subregion. */
-		if (gtk_text_iter_in_range (&end, &sr_start_iter, &sr_end_iter) &&
-		    !gtk_text_iter_equal (&end, &sr_end_iter))
-		{
-			/* The ending point is also inside the first
-			 * subregion: we need to split.
-			 */
-			Subregion *new_sr = g_slice_new0 (Subregion);
-			new_sr->end = sr->end;
-			new_sr->start = gtk_text_buffer_create_mark (priv->buffer,
-								     NULL,
-								     &end,
-								     TRUE);
-
-			start_node = g_list_insert_before (start_node, start_node->next, new_sr);
-
-			sr->end = gtk_text_buffer_create_mark (priv->buffer,
-							       NULL,
-							       &start,
-							       FALSE);
-
-			/* No further processing needed. */
-			DEBUG (g_message ("subregion split"));
-
-			return;
-		}
-		else
-		{
-			/* The ending point is outside, so just move
-			 * the end of the subregion to the starting point.
-			 */
-			gtk_text_buffer_move_mark (priv->buffer, sr->end, &start);
-		}
+		pieces[n_pieces].start = get_subregion (priv, start_index)->start;
+		pieces[n_pieces].end = start;
+		n_pieces++;
 	}
-	else
-	{
-		/* The starting point is outside (and so to the left)
-		 * of the first subregion.
-		 */
-		DEBUG (g_message ("start is outside"));
 
-		start_is_outside = TRUE;
+	if (get_subregion (priv, end_index)->end > end)
+	{
+		pieces[n_pieces].start = end;
+		pieces[n_pieces].end = get_subregion (priv, end_index)->end;
+		n_pieces++;
 	}
 
-	/* Deal with the end point. */
-	if (start_node != end_node)
+	g_array_remove_range (priv->subregions,
+			      start_index,
+			      end_index - start_index + 1);
+
+	if (n_pieces > 0)
 	{
-		sr = end_node->data;
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_start_iter, sr->start);
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_end_iter, sr->end);
+		g_array_insert_vals (priv->subregions, start_index, pieces, n_pieces);
 	}
 
-	if (gtk_text_iter_in_range (&end, &sr_start_iter, &sr_end_iter) &&
-	    !gtk_text_iter_equal (&end, &sr_end_iter))
-	{
-		/* Ending point is inside, move the start mark. */
-		gtk_text_buffer_move_mark (priv->buffer, sr->start, &end);
-	}
-	else
-	{
-		end_is_outside = TRUE;
-		DEBUG (g_message ("end is outside"));
-	}
+	priv->timestamp++;
+}
+
+/*
+ * _gspell_region_subtract_subregion:
+ * @region: a #GspellRegion.
+ * @_start: the start of the subregion.
+ * @_end: the end of the subregion.
+ *
+ * Subtracts the subregion delimited by @_start and @_end from @region.
+ */
+void
+_gspell_region_subtract_subregion (GspellRegion   *region,
+				      const GtkTextIter *_start,
+				      const GtkTextIter *_end)
+{
+	GspellRegionPrivate *priv;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	g_return_if_fail (GSPELL_IS_REGION (region));
+	g_return_if_fail (_start != NULL);
+	g_return_if_fail (_end != NULL);
 
-	/* Finally remove any intermediate subregions. */
-	done = FALSE;
-	node = start_node;
+	priv = get_updated_priv (region);
 
-	while (!done)
+	if (priv == NULL)
 	{
-		if (node == end_node)
-		{
-			/* We are done, exit in the next iteration. */
-			done = TRUE;
-		}
-
-		if ((node == start_node && !start_is_outside) ||
-		    (node == end_node && !end_is_outside))
-		{
-			/* Skip starting or ending node. */
-			node = node->next;
-		}
-		else
-		{
-			GList *l = node->next;
-			sr = node->data;
-			gtk_text_buffer_delete_mark (priv->buffer, sr->start);
-			gtk_text_buffer_delete_mark (priv->buffer, sr->end);
-			g_slice_free (Subregion, sr);
-			priv->subregions = g_list_delete_link (priv->subregions, node);
-			node = l;
-		}
+		return;
 	}
 
-	priv->timestamp++;
+	start = *_start;
+	end = *_end;
 
+	DEBUG (g_print ("---\n"));
 	DEBUG (print_region (region));
 
-	/* Now get rid of empty subregions. */
-	_gspell_region_clear_zero_length_subregions (region);
+	gtk_text_iter_order (&start, &end);
+
+	subtract_subregion_offsets (priv,
+				    gtk_text_iter_get_offset (&start),
+				    gtk_text_iter_get_offset (&end));
 
 	DEBUG (print_region (region));
 }
@@ -757,50 +1053,29 @@ void
 _gspell_region_subtract_region (GspellRegion *region,
 				   GspellRegion *region_to_subtract)
 {
-	GtkTextBuffer *region_buffer;
-	GtkTextBuffer *region_to_subtract_buffer;
-	GspellRegionIter iter;
+	GspellRegionPrivate *priv;
+	GspellRegionPrivate *priv_to_subtract;
 
 	g_return_if_fail (GSPELL_IS_REGION (region));
 	g_return_if_fail (region_to_subtract == NULL || GSPELL_IS_REGION (region_to_subtract));
 
-	region_buffer = _gspell_region_get_buffer (region);
-	region_to_subtract_buffer = _gspell_region_get_buffer (region_to_subtract);
-	g_return_if_fail (region_buffer == region_to_subtract_buffer);
-
-	if (region_buffer == NULL)
+	if (region_to_subtract == NULL ||
+	    !get_updated_privs (region, region_to_subtract, &priv, &priv_to_subtract) ||
+	    priv_to_subtract->subregions->len == 0)
 	{
 		return;
 	}
 
-	_gspell_region_get_start_region_iter (region_to_subtract, &iter);
-
-	while (!_gspell_region_iter_is_end (&iter))
-	{
-		GtkTextIter subregion_start;
-		GtkTextIter subregion_end;
-
-		if (!_gspell_region_iter_get_subregion (&iter,
-							   &subregion_start,
-							   &subregion_end))
-		{
-			break;
-		}
-
-		_gspell_region_subtract_subregion (region,
-						      &subregion_start,
-						      &subregion_end);
-
-		_gspell_region_iter_next (&iter);
-	}
+	subtract_subregions (priv->subregions, priv_to_subtract->subregions, priv->scratch);
+	swap_scratch (priv);
 }
 
 /*
  * _gspell_region_is_empty:
  * @region: (nullable): a #GspellRegion, or %NULL.
  *
- * Returns whether the @region is empty. 
- * 
+ * Returns whether the @region is empty.
+ *
  * A %NULL @region is considered empty.
  *
  * Returns: whether the @region is empty.
@@ -808,44 +1083,57 @@ _gspell_region_subtract_region (GspellRegion *region,
 gboolean
 _gspell_region_is_empty (GspellRegion *region)
 {
-	GspellRegionIter region_iter;
+	GspellRegionPrivate *priv;
 
 	if (region == NULL)
 	{
 		return TRUE;
 	}
 
-	/* A #GspellRegion can contain empty subregions. So checking the
-	 * number of subregions is not sufficient.
-	 * When calling _gspell_region_add_subregion() with equal iters, the
-	 * subregion is not added. But when a subregion becomes empty, due to
-	 * text deletion, the subregion is not removed from the
-	 * #GspellRegion.
+	/* The subregions emptied by a text deletion are removed when the
+	 * edits are applied, so checking the number of subregions is
+	 * sufficient.
 	 */
+	priv = get_updated_priv (region);
 
-	_gspell_region_get_start_region_iter (region, &region_iter);
+	return priv == NULL || priv->subregions->len == 0;
+}
+
+/*
+ * _gspell_region_get_n_chars:
+ * @region: (nullable): a #GspellRegion, or %NULL.
+ *
+ * A %NULL @region is considered empty.
+ *
+ * Returns: the number of characters contained in @region.
+ */
+gint
+_gspell_region_get_n_chars (GspellRegion *region)
+{
+	GspellRegionPrivate *priv;
+	gint n_chars = 0;
+	guint i;
 
-	while (!_gspell_region_iter_is_end (&region_iter))
+	if (region == NULL)
 	{
-		GtkTextIter subregion_start;
-		GtkTextIter subregion_end;
+		return 0;
+	}
 
-		if (!_gspell_region_iter_get_subregion (&region_iter,
-							   &subregion_start,
-							   &subregion_end))
-		{
-			return TRUE;
-		}
+	priv = get_updated_priv (region);
 
-		if (!gtk_text_iter_equal (&subregion_start, &subregion_end))
-		{
-			return FALSE;
-		}
+	if (priv == NULL)
+	{
+		return 0;
+	}
+
+	for (i = 0; i < priv->subregions->len; i++)
+	{
+		Subregion *subregion = get_subregion (priv, i);
 
-		_gspell_region_iter_next (&region_iter);
+		n_chars += subregion->end - subregion->start;
 	}
 
-	return TRUE;
+	return n_chars;
 }
 
 /*
@@ -870,26 +1158,26 @@ _gspell_region_get_bounds (GspellRegion *region,
 
 	g_return_val_if_fail (GSPELL_IS_REGION (region), FALSE);
 
-	priv = _gspell_region_get_instance_private (region);
+	priv = get_updated_priv (region);
 
-	if (priv->buffer == NULL ||
-	    _gspell_region_is_empty (region))
+	if (priv == NULL ||
+	    priv->subregions->len == 0)
 	{
 		return FALSE;
 	}
 
-	g_assert (priv->subregions != NULL);
-
 	if (start != NULL)
 	{
-		Subregion *first_subregion = priv->subregions->data;
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, start, first_subregion->start);
+		gtk_text_buffer_get_iter_at_offset (priv->buffer,
+						    start,
+						    get_subregion (priv, 0)->start);
 	}
 
 	if (end != NULL)
 	{
-		Subregion *last_subregion = g_list_last (priv->subregions)->data;
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, end, last_subregion->end);
+		gtk_text_buffer_get_iter_at_offset (priv->buffer,
+						    end,
+						    get_subregion (priv, priv->subregions->len - 1)->end);
 	}
 
 	return TRUE;
@@ -902,8 +1190,8 @@ _gspell_region_get_bounds (GspellRegion *region,
  * @_end: the end of the subregion.
  *
  * Returns the intersection between @region and the subregion delimited by
- * @_start and @_end. 
- * 
+ * @_start and @_end.
+ *
  * @region is not modified.
  *
  * Returns: (transfer full) (nullable): the intersection as a new
@@ -917,155 +1205,61 @@ _gspell_region_intersect_subregion (GspellRegion   *region,
 	GspellRegionPrivate *priv;
 	GspellRegion *new_region;
 	GspellRegionPrivate *new_priv;
-	GList *start_node;
-	GList *end_node;
-	GList *node;
-	GtkTextIter sr_start_iter;
-	GtkTextIter sr_end_iter;
-	Subregion *sr;
-	Subregion *new_sr;
-	gboolean done;
-	GtkTextIter start;
-	GtkTextIter end;
+	gint start_index;
+	gint end_index;
+	gint index;
+	GtkTextIter start_iter;
+	GtkTextIter end_iter;
+	gint start;
+	gint end;
 
 	g_return_val_if_fail (GSPELL_IS_REGION (region), NULL);
 	g_return_val_if_fail (_start != NULL, NULL);
 	g_return_val_if_fail (_end != NULL, NULL);
 
-	priv = _gspell_region_get_instance_private (region);
+	priv = get_updated_priv (region);
 
-	if (priv->buffer == NULL)
+	if (priv == NULL)
 	{
 		return NULL;
 	}
 
-	start = *_start;
-	end = *_end;
+	start_iter = *_start;
+	end_iter = *_end;
 
-	gtk_text_iter_order (&start, &end);
+	gtk_text_iter_order (&start_iter, &end_iter);
+
+	start = gtk_text_iter_get_offset (&start_iter);
+	end = gtk_text_iter_get_offset (&end_iter);
+
+	if (start == end)
+	{
+		return NULL;
+	}
 
 	/* Find bounding subregions. */
-	start_node = find_nearest_subregion (region, &start, NULL, FALSE, FALSE);
-	end_node = find_nearest_subregion (region, &end, start_node, TRUE, FALSE);
+	start_index = find_nearest_subregion (priv, start, 0, FALSE, FALSE);
+	end_index = find_nearest_subregion (priv, end, start_index, TRUE, FALSE);
 
 	/* Easy case first. */
-	if (start_node == NULL || end_node == NULL || end_node == start_node->prev)
+	if (start_index == (gint) priv->subregions->len || end_index < start_index)
 	{
 		return NULL;
 	}
 
 	new_region = _gspell_region_new (priv->buffer);
 	new_priv = _gspell_region_get_instance_private (new_region);
-	done = FALSE;
-
-	sr = start_node->data;
-	gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_start_iter, sr->start);
-	gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_end_iter, sr->end);
-
-	/* Starting node. */
-	if (gtk_text_iter_in_range (&start, &sr_start_iter, &sr_end_iter))
-	{
-		new_sr = g_slice_new0 (Subregion);
-		new_priv->subregions = g_list_prepend (new_priv->subregions, new_sr);
-
-		new_sr->start = gtk_text_buffer_create_mark (new_priv->buffer,
-							     NULL,
-							     &start,
-							     TRUE);
-
-		if (start_node == end_node)
-		{
-			/* Things will finish shortly. */
-			done = TRUE;
-			if (gtk_text_iter_in_range (&end, &sr_start_iter, &sr_end_iter))
-			{
-				new_sr->end = gtk_text_buffer_create_mark (new_priv->buffer,
-									   NULL,
-									   &end,
-									   FALSE);
-			}
-			else
-			{
-				new_sr->end = gtk_text_buffer_create_mark (new_priv->buffer,
-									   NULL,
-									   &sr_end_iter,
-									   FALSE);
-			}
-		}
-		else
-		{
-			new_sr->end = gtk_text_buffer_create_mark (new_priv->buffer,
-								   NULL,
-								   &sr_end_iter,
-								   FALSE);
-		}
-
-		node = start_node->next;
-	}
-	else
-	{
-		/* start should be the same as the subregion, so copy it in the
-		 * loop.
-		 */
-		node = start_node;
-	}
 
-	if (!done)
+	for (index = start_index; index <= end_index; index++)
 	{
-		while (node != end_node)
-		{
-			/* Copy intermediate subregions verbatim. */
-			sr = node->data;
-			gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_start_iter, sr->start);
-			gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_end_iter, sr->end);
-
-			new_sr = g_slice_new0 (Subregion);
-			new_priv->subregions = g_list_prepend (new_priv->subregions, new_sr);
-
-			new_sr->start = gtk_text_buffer_create_mark (new_priv->buffer,
-								     NULL,
-								     &sr_start_iter,
-								     TRUE);
-
-			new_sr->end = gtk_text_buffer_create_mark (new_priv->buffer,
-								   NULL,
-								   &sr_end_iter,
-								   FALSE);
-
-			/* Next node. */
-			node = node->next;
-		}
-
-		/* Ending node. */
-		sr = node->data;
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_start_iter, sr->start);
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &sr_end_iter, sr->end);
+		const Subregion *sr = get_subregion (priv, index);
+		Subregion new_sr;
 
-		new_sr = g_slice_new0 (Subregion);
-		new_priv->subregions = g_list_prepend (new_priv->subregions, new_sr);
-
-		new_sr->start = gtk_text_buffer_create_mark (new_priv->buffer,
-							     NULL,
-							     &sr_start_iter,
-							     TRUE);
-
-		if (gtk_text_iter_in_range (&end, &sr_start_iter, &sr_end_iter))
-		{
-			new_sr->end = gtk_text_buffer_create_mark (new_priv->buffer,
-								   NULL,
-								   &end,
-								   FALSE);
-		}
-		else
-		{
-			new_sr->end = gtk_text_buffer_create_mark (new_priv->buffer,
-								   NULL,
-								   &sr_end_iter,
-								   FALSE);
-		}
+		new_sr.start = MAX (sr->start, start);
+		new_sr.end = MIN (sr->end, end);
+		g_array_append_val (new_priv->subregions, new_sr);
 	}
 
-	new_priv->subregions = g_list_reverse (new_priv->subregions);
 	return new_region;
 }
 
@@ -1074,7 +1268,7 @@ _gspell_region_intersect_subregion (GspellRegion   *region,
  * @region1: (nullable): a #GspellRegion, or %NULL.
  * @region2: (nullable): a #GspellRegion, or %NULL.
  *
- * Returns the intersection between @region1 and @region2. 
+ * Returns the intersection between @region1 and @region2.
  *
  * @region1 and @region2 are not modified.
  *
@@ -1085,10 +1279,10 @@ GspellRegion *
 _gspell_region_intersect_region (GspellRegion *region1,
 				    GspellRegion *region2)
 {
-	GtkTextBuffer *region1_buffer;
-	GtkTextBuffer *region2_buffer;
-	GspellRegion *full_intersect = NULL;
-	GspellRegionIter region2_iter;
+	GspellRegionPrivate *priv1;
+	GspellRegionPrivate *priv2;
+	GspellRegion *new_region;
+	GspellRegionPrivate *new_priv;
 
 	g_return_val_if_fail (region1 == NULL || GSPELL_IS_REGION (region1), NULL);
 	g_return_val_if_fail (region2 == NULL || GSPELL_IS_REGION (region2), NULL);
@@ -1106,48 +1300,156 @@ _gspell_region_intersect_region (GspellRegion *region1,
 		return g_object_ref (region1);
 	}
 
-	region1_buffer = _gspell_region_get_buffer (region1);
-	region2_buffer = _gspell_region_get_buffer (region2);
-	g_return_val_if_fail (region1_buffer == region2_buffer, NULL);
-
-	if (region1_buffer == NULL)
+	if (!get_updated_privs (region1, region2, &priv1, &priv2))
 	{
 		return NULL;
 	}
 
-	_gspell_region_get_start_region_iter (region2, &region2_iter);
+	new_region = _gspell_region_new (priv1->buffer);
+	new_priv = _gspell_region_get_instance_private (new_region);
+
+	intersect_subregions (priv1->subregions, priv2->subregions, new_priv->subregions);
 
-	while (!_gspell_region_iter_is_end (&region2_iter))
+	if (new_priv->subregions->len == 0)
 	{
-		GtkTextIter subregion2_start;
-		GtkTextIter subregion2_end;
-		GspellRegion *sub_intersect;
+		g_clear_object (&new_region);
+	}
 
-		if (!_gspell_region_iter_get_subregion (&region2_iter,
-							   &subregion2_start,
-							   &subregion2_end))
-		{
-			break;
-		}
+	return new_region;
+}
+
+/*
+ * _gspell_region_intersect_subregion_in_place:
+ * @region: a #GspellRegion.
+ * @_start: the start of the subregion.
+ * @_end: the end of the subregion.
+ *
+ * Like _gspell_region_intersect_subregion(), but stores the intersection in
+ * @region instead of creating a new #GspellRegion.
+ */
+void
+_gspell_region_intersect_subregion_in_place (GspellRegion      *region,
+					     const GtkTextIter *_start,
+					     const GtkTextIter *_end)
+{
+	GspellRegionPrivate *priv;
+	gint start_index;
+	gint end_index;
+	GtkTextIter start_iter;
+	GtkTextIter end_iter;
+	gint start;
+	gint end;
+
+	g_return_if_fail (GSPELL_IS_REGION (region));
+	g_return_if_fail (_start != NULL);
+	g_return_if_fail (_end != NULL);
 
-		sub_intersect = _gspell_region_intersect_subregion (region1,
-								       &subregion2_start,
-								       &subregion2_end);
+	priv = get_updated_priv (region);
 
-		if (full_intersect == NULL)
-		{
-			full_intersect = sub_intersect;
-		}
-		else
-		{
-			_gspell_region_add_region (full_intersect, sub_intersect);
-			g_clear_object (&sub_intersect);
-		}
+	if (priv == NULL)
+	{
+		return;
+	}
+
+	start_iter = *_start;
+	end_iter = *_end;
+
+	gtk_text_iter_order (&start_iter, &end_iter);
+
+	start = gtk_text_iter_get_offset (&start_iter);
+	end = gtk_text_iter_get_offset (&end_iter);
+
+	start_index = find_nearest_subregion (priv, start, 0, FALSE, FALSE);
+	end_index = find_nearest_subregion (priv, end, start_index, TRUE, FALSE);
+
+	if (start == end ||
+	    start_index == (gint) priv->subregions->len ||
+	    end_index < start_index)
+	{
+		g_array_set_size (priv->subregions, 0);
+		priv->timestamp++;
+		return;
+	}
+
+	g_array_set_size (priv->subregions, end_index + 1);
+
+	if (start_index > 0)
+	{
+		g_array_remove_range (priv->subregions, 0, start_index);
+	}
+
+	get_subregion (priv, 0)->start = MAX (get_subregion (priv, 0)->start, start);
+	get_subregion (priv, priv->subregions->len - 1)->end =
+		MIN (get_subregion (priv, priv->subregions->len - 1)->end, end);
+
+	priv->timestamp++;
+}
+
+/*
+ * _gspell_region_intersect_region_in_place:
+ * @region: a #GspellRegion.
+ * @other: (nullable): a #GspellRegion, or %NULL.
+ *
+ * Like _gspell_region_intersect_region(), but stores the intersection in
+ * @region instead of creating a new #GspellRegion. A %NULL @other doesn't
+ * modify @region.
+ *
+ * @other is not modified.
+ */
+void
+_gspell_region_intersect_region_in_place (GspellRegion *region,
+					  GspellRegion *other)
+{
+	GspellRegionPrivate *priv;
+	GspellRegionPrivate *other_priv;
+
+	g_return_if_fail (GSPELL_IS_REGION (region));
+	g_return_if_fail (other == NULL || GSPELL_IS_REGION (other));
+
+	if (other == NULL ||
+	    other == region ||
+	    !get_updated_privs (region, other, &priv, &other_priv))
+	{
+		return;
+	}
 
-		_gspell_region_iter_next (&region2_iter);
+	intersect_subregions (priv->subregions, other_priv->subregions, priv->scratch);
+	swap_scratch (priv);
+}
+
+/*
+ * _gspell_region_set_region:
+ * @region: a #GspellRegion.
+ * @source: a #GspellRegion.
+ *
+ * Replaces the subregions of @region by a copy of the subregions of @source.
+ * Combined with the in-place operations, it permits to reuse the same
+ * #GspellRegion for temporary results.
+ *
+ * @source is not modified.
+ */
+void
+_gspell_region_set_region (GspellRegion *region,
+			   GspellRegion *source)
+{
+	GspellRegionPrivate *priv;
+	GspellRegionPrivate *source_priv;
+
+	g_return_if_fail (GSPELL_IS_REGION (region));
+	g_return_if_fail (GSPELL_IS_REGION (source));
+
+	if (region == source ||
+	    !get_updated_privs (region, source, &priv, &source_priv))
+	{
+		return;
 	}
 
-	return full_intersect;
+	g_array_set_size (priv->subregions, 0);
+	g_array_append_vals (priv->subregions,
+			     source_priv->subregions->data,
+			     source_priv->subregions->len);
+
+	priv->timestamp++;
 }
 
 static gboolean
@@ -1180,7 +1482,7 @@ invalid:
  * @region: a #GspellRegion.
  * @iter: (out): iterator to initialize to the first subregion.
  *
- * Initializes a [struct@RegionIter] to the first subregion of @region. 
+ * Initializes a [struct@RegionIter] to the first subregion of @region.
  *
  * If @region is empty, @iter will be initialized to the end iterator.
  */
@@ -1194,13 +1496,18 @@ _gspell_region_get_start_region_iter (GspellRegion     *region,
 	g_return_if_fail (GSPELL_IS_REGION (region));
 	g_return_if_fail (iter != NULL);
 
+	/* Apply the pending edits now, so that the timestamp doesn't change
+	 * during the iteration if the buffer is not modified.
+	 */
+	get_updated_priv (region);
+
 	priv = _gspell_region_get_instance_private (region);
 	real = (GspellRegionIterReal *)iter;
 
-	/* priv->subregions may be NULL, -> end iter */
+	/* priv->subregions may be empty, -> end iter */
 
 	real->region = region;
-	real->subregions = priv->subregions;
+	real->subregion_index = 0;
 	real->region_timestamp = priv->timestamp;
 }
 
@@ -1214,13 +1521,15 @@ gboolean
 _gspell_region_iter_is_end (GspellRegionIter *iter)
 {
 	GspellRegionIterReal *real;
+	GspellRegionPrivate *priv;
 
 	g_return_val_if_fail (iter != NULL, FALSE);
 
 	real = (GspellRegionIterReal *)iter;
 	g_return_val_if_fail (check_iterator (real), FALSE);
 
-	return real->subregions == NULL;
+	priv = _gspell_region_get_instance_private (real->region);
+	return real->subregion_index >= priv->subregions->len;
 }
 
 /*
@@ -1236,15 +1545,18 @@ gboolean
 _gspell_region_iter_next (GspellRegionIter *iter)
 {
 	GspellRegionIterReal *real;
+	GspellRegionPrivate *priv;
 
 	g_return_val_if_fail (iter != NULL, FALSE);
 
 	real = (GspellRegionIterReal *)iter;
 	g_return_val_if_fail (check_iterator (real), FALSE);
 
-	if (real->subregions != NULL)
+	priv = _gspell_region_get_instance_private (real->region);
+
+	if (real->subregion_index < priv->subregions->len)
 	{
-		real->subregions = real->subregions->next;
+		real->subregion_index++;
 		return TRUE;
 	}
 
@@ -1276,29 +1588,24 @@ _gspell_region_iter_get_subregion (GspellRegionIter *iter,
 	real = (GspellRegionIterReal *)iter;
 	g_return_val_if_fail (check_iterator (real), FALSE);
 
-	if (real->subregions == NULL)
-	{
-		return FALSE;
-	}
-
-	priv = _gspell_region_get_instance_private (real->region);
+	priv = get_updated_priv (real->region);
 
-	if (priv->buffer == NULL)
+	if (priv == NULL ||
+	    real->subregion_index >= priv->subregions->len)
 	{
 		return FALSE;
 	}
 
-	sr = real->subregions->data;
-	g_return_val_if_fail (sr != NULL, FALSE);
+	sr = get_subregion (priv, real->subregion_index);
 
 	if (start != NULL)
 	{
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, start, sr->start);
+		gtk_text_buffer_get_iter_at_offset (priv->buffer, start, sr->start);
 	}
 
 	if (end != NULL)
 	{
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, end, sr->end);
+		gtk_text_buffer_get_iter_at_offset (priv->buffer, end, sr->end);
 	}
 
 	return TRUE;
@@ -1321,33 +1628,127 @@ _gspell_region_to_string (GspellRegion *region)
 {
 	GspellRegionPrivate *priv;
 	GString *string;
-	GList *l;
+	guint i;
 
 	g_return_val_if_fail (GSPELL_IS_REGION (region), NULL);
 
-	priv = _gspell_region_get_instance_private (region);
+	priv = get_updated_priv (region);
 
-	if (priv->buffer == NULL)
+	if (priv == NULL)
 	{
 		return NULL;
 	}
 
 	string = g_string_new ("Subregions:");
 
-	for (l = priv->subregions; l != NULL; l = l->next)
+	for (i = 0; i < priv->subregions->len; i++)
 	{
-		Subregion *sr = l->data;
-		GtkTextIter start;
-		GtkTextIter end;
-
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &start, sr->start);
-		gtk_text_buffer_get_iter_at_mark (priv->buffer, &end, sr->end);
+		Subregion *sr = get_subregion (priv, i);
 
 		g_string_append_printf (string,
 					" %d-%d",
-					gtk_text_iter_get_offset (&start),
-					gtk_text_iter_get_offset (&end));
+					sr->start,
+					sr->end);
 	}
 
 	return g_string_free (string, FALSE);
 }
+
+/*
+ * _gspell_region_view_init:
+ * @view: (out): the view to initialize.
+ * @region: a #GspellRegion.
+ * @start_offset: the start of the range.
+ * @end_offset: the end of the range, or %G_MAXINT for the end of the buffer.
+ *
+ * Initializes @view on the subregions of @region in [@start_offset,
+ * @end_offset]. The view borrows the subregions: @region must not be modified,
+ * and the buffer must not be edited, while @view is used.
+ */
+void
+_gspell_region_view_init (GspellRegionView *view,
+			  GspellRegion     *region,
+			  gint              start_offset,
+			  gint              end_offset)
+{
+	GspellRegionViewReal *real;
+	GspellRegionPrivate *priv;
+
+	g_return_if_fail (view != NULL);
+	g_return_if_fail (GSPELL_IS_REGION (region));
+
+	real = (GspellRegionViewReal *)view;
+	real->region = region;
+	real->subregion_index = 0;
+	real->end_index = 0;
+	real->start = start_offset;
+	real->end = end_offset;
+
+	priv = get_updated_priv (region);
+
+	if (priv != NULL && start_offset < end_offset)
+	{
+		gint start_index;
+		gint end_index;
+
+		start_index = find_nearest_subregion (priv, start_offset, 0, FALSE, FALSE);
+		end_index = find_nearest_subregion (priv, end_offset, start_index, TRUE, FALSE);
+
+		real->subregion_index = start_index;
+		real->end_index = MAX (end_index + 1, start_index);
+	}
+
+	priv = _gspell_region_get_instance_private (region);
+	real->region_timestamp = priv->timestamp;
+}
+
+/*
+ * _gspell_region_view_next:
+ * @view: a #GspellRegionView.
+ * @start_offset: (out): the start of the next subregion.
+ * @end_offset: (out): the end of the next subregion.
+ *
+ * Gets the next subregion of @view, clipped to the range of @view.
+ *
+ * Returns: %TRUE if @start_offset and @end_offset have been set, or %FALSE if
+ *   there are no more subregions.
+ */
+gboolean
+_gspell_region_view_next (GspellRegionView *view,
+			  gint             *start_offset,
+			  gint             *end_offset)
+{
+	GspellRegionViewReal *real;
+	GspellRegionPrivate *priv;
+	const Subregion *sr;
+
+	g_return_val_if_fail (view != NULL, FALSE);
+	g_return_val_if_fail (start_offset != NULL, FALSE);
+	g_return_val_if_fail (end_offset != NULL, FALSE);
+
+	real = (GspellRegionViewReal *)view;
+
+	if (real->subregion_index >= real->end_index)
+	{
+		return FALSE;
+	}
+
+	priv = _gspell_region_get_instance_private (real->region);
+
+	if (real->region_timestamp != priv->timestamp ||
+	    priv->pending_edits->len > 0)
+	{
+		g_warning ("Invalid GspellRegionView: the region has been "
+			   "modified or the buffer has been edited since the "
+			   "view was initialized.");
+		return FALSE;
+	}
+
+	sr = get_subregion (priv, real->subregion_index);
+	real->subregion_index++;
+
+	*start_offset = MAX (sr->start, real->start);
+	*end_offset = MIN (sr->end, real->end);
+
+	return TRUE;
+}
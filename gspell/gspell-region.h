@@ -1,4 +1,6 @@
-/* Do not edit: this file is generated from https://gitlab.gnome.org/GNOME/gtksourceview/raw/master/gtksourceview/gtksourceregion.h */
+/* Originally generated from https://gitlab.gnome.org/GNOME/gtksourceview/raw/master/gtksourceview/gtksourceregion.h,
+ * now maintained in gspell: do not regenerate it with update-sourceregion.sh.
+ */
 
 /*
  * This file is part of GtkSourceView
@@ -54,7 +56,26 @@ struct _GspellRegionIter
 	/*< private >*/
 	gpointer dummy1;
 	guint32  dummy2;
-	gpointer dummy3;
+	guint    dummy3;
+};
+
+/*
+ * GspellRegionView:
+ *
+ * An opaque datatype, to allocate on the stack.
+ *
+ * Ignore all its fields and initialize the view with _gspell_region_view_init().
+ */
+typedef struct _GspellRegionView GspellRegionView;
+struct _GspellRegionView
+{
+	/*< private >*/
+	gpointer dummy1;
+	guint32  dummy2;
+	guint    dummy3;
+	guint    dummy4;
+	gint     dummy5;
+	gint     dummy6;
 };
 
 GSPELL_AVAILABLE_IN_ALL
@@ -62,6 +83,14 @@ GspellRegion *_gspell_region_new                   (GtkTextBuffer       *buffer)
 GSPELL_AVAILABLE_IN_ALL
 GtkTextBuffer   *_gspell_region_get_buffer            (GspellRegion     *region);
 GSPELL_AVAILABLE_IN_ALL
+void             _gspell_region_insert_text           (GspellRegion     *region,
+                                                          gint                 offset,
+                                                          gint                 n_chars);
+GSPELL_AVAILABLE_IN_ALL
+void             _gspell_region_delete_text           (GspellRegion     *region,
+                                                          gint                 start_offset,
+                                                          gint                 end_offset);
+GSPELL_AVAILABLE_IN_ALL
 void             _gspell_region_add_subregion         (GspellRegion     *region,
                                                           const GtkTextIter   *_start,
                                                           const GtkTextIter   *_end);
@@ -83,8 +112,22 @@ GSPELL_AVAILABLE_IN_ALL
 GspellRegion *_gspell_region_intersect_region      (GspellRegion     *region1,
                                                           GspellRegion     *region2);
 GSPELL_AVAILABLE_IN_ALL
+void             _gspell_region_intersect_subregion_in_place
+                                                         (GspellRegion     *region,
+                                                          const GtkTextIter   *_start,
+                                                          const GtkTextIter   *_end);
+GSPELL_AVAILABLE_IN_ALL
+void             _gspell_region_intersect_region_in_place
+                                                         (GspellRegion     *region,
+                                                          GspellRegion     *other);
+GSPELL_AVAILABLE_IN_ALL
+void             _gspell_region_set_region            (GspellRegion     *region,
+                                                          GspellRegion     *source);
+GSPELL_AVAILABLE_IN_ALL
 gboolean         _gspell_region_is_empty              (GspellRegion     *region);
 GSPELL_AVAILABLE_IN_ALL
+gint             _gspell_region_get_n_chars           (GspellRegion     *region);
+GSPELL_AVAILABLE_IN_ALL
 gboolean         _gspell_region_get_bounds            (GspellRegion     *region,
                                                           GtkTextIter         *start,
                                                           GtkTextIter         *end);
@@ -100,6 +143,15 @@ gboolean         _gspell_region_iter_get_subregion    (GspellRegionIter *iter,
                                                           GtkTextIter         *start,
                                                           GtkTextIter         *end);
 GSPELL_AVAILABLE_IN_ALL
+void             _gspell_region_view_init             (GspellRegionView *view,
+                                                          GspellRegion     *region,
+                                                          gint                 start_offset,
+                                                          gint                 end_offset);
+GSPELL_AVAILABLE_IN_ALL
+gboolean         _gspell_region_view_next             (GspellRegionView *view,
+                                                          gint                *start_offset,
+                                                          gint                *end_offset);
+GSPELL_AVAILABLE_IN_ALL
 gchar           *_gspell_region_to_string             (GspellRegion     *region);
 
 G_END_DECLS
@@ -0,0 +1,544 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gspell-scheduler.h"
+
+/* The process-wide scheduler of the spell-checking work, on the main thread.
+ *
+ * Each client (a GtkTextBuffer with its inline checker) has two kinds of work:
+ * - The checks, for example of the visible region after an edit, at a time
+ *   chosen by the client. All the clients share one GSource, whose ready time
+ *   is the earliest check time.
+ * - The background work, done at idle priority. All the clients share one
+ *   idle source.
+ *
+ * When several clients have work at the same time (a word added to the
+ * personal dictionary, a language change), they are served by priority: the
+ * focused view first, then the visible views, then the hidden buffers. A
+ * dispatch stops when its time budget is spent, and the clients not yet
+ * served wait for the next frame, so that dozens of buffers don't stall the
+ * user interface. The clients served are moved to the end of the list, so that
+ * the clients with the same priority are served in turn.
+ *
+ * The priorities are computed once at the start of a dispatch, which then
+ * serves the clients from that snapshot.
+ */
+
+/* A quarter of a frame at 60 Hz: the rest of the frame is left to the layout
+ * and the drawing.
+ */
+#define CHECK_TIME_BUDGET 4000
+
+/* Minimum interval between two dispatches that have spent their budget. */
+#define FRAME_INTERVAL 16667
+
+/* For the background work, in microseconds. Small enough to not delay the
+ * input events.
+ */
+#define BACKGROUND_TIME_BUDGET 2000
+
+struct _GspellSchedulerClient
+{
+	GspellSchedulerPriorityFunc priority_func;
+	GspellSchedulerCheckFunc check_func;
+	GspellSchedulerBackgroundFunc background_func;
+	gpointer user_data;
+
+	/* -1 if no check is scheduled. */
+	gint64 check_time;
+
+	/* Computed at the start of the dispatch, see get_dispatch_queue(). */
+	GspellSchedulerPriority priority;
+
+	/* Of the last dispatch that has served the client, so that it is served
+	 * once per dispatch.
+	 */
+	guint check_serial;
+	guint background_serial;
+
+	guint background_work : 1;
+
+	/* Removed during a dispatch, freed at its end. */
+	guint removed : 1;
+};
+
+typedef struct _Scheduler Scheduler;
+
+struct _Scheduler
+{
+	/* GspellSchedulerClient*, in the order in which they are served within
+	 * a priority.
+	 */
+	GPtrArray *clients;
+
+	GSource *check_source;
+
+	/* No dispatch before this time, to respect the budget per frame. */
+	gint64 next_dispatch_time;
+
+	guint background_id;
+
+	guint check_serial;
+	guint background_serial;
+
+	/* List of GspellSchedulerClient* removed during a dispatch. */
+	GSList *removed_clients;
+	guint dispatch_depth;
+};
+
+static Scheduler scheduler;
+
+static gboolean check_source_dispatch (GSource     *source,
+				       GSourceFunc  callback,
+				       gpointer     user_data);
+
+static GSourceFuncs check_source_funcs =
+{
+	NULL,
+	NULL,
+	check_source_dispatch,
+	NULL,
+};
+
+static void
+update_check_source (void)
+{
+	gint64 ready_time = -1;
+	guint i;
+
+	if (scheduler.check_source == NULL)
+	{
+		return;
+	}
+
+	for (i = 0; i < scheduler.clients->len; i++)
+	{
+		GspellSchedulerClient *client = g_ptr_array_index (scheduler.clients, i);
+
+		if (client->check_time != -1 &&
+		    (ready_time == -1 || client->check_time < ready_time))
+		{
+			ready_time = client->check_time;
+		}
+	}
+
+	if (ready_time != -1)
+	{
+		ready_time = MAX (ready_time, scheduler.next_dispatch_time);
+	}
+
+	g_source_set_ready_time (scheduler.check_source, ready_time);
+}
+
+/* Whether @client has work to do in the current check or background dispatch.
+ * It can change during the dispatch, with the work done by the other clients.
+ */
+static gboolean
+client_is_ready (GspellSchedulerClient *client,
+		 gboolean               background,
+		 gint64                 now)
+{
+	if (client->removed)
+	{
+		return FALSE;
+	}
+
+	if (background)
+	{
+		return (client->background_work &&
+			client->background_serial != scheduler.background_serial);
+	}
+
+	return (client->check_time != -1 &&
+		client->check_time <= now &&
+		client->check_serial != scheduler.check_serial);
+}
+
+/* Returns the clients ready at the start of a dispatch, in the order in which
+ * they are served: by priority, and in the order of the list within a
+ * priority. The priority of each client is computed once.
+ */
+static GPtrArray *
+get_dispatch_queue (gboolean background,
+		    gint64   now)
+{
+	GPtrArray *ready_clients;
+	GPtrArray *queue;
+	GspellSchedulerPriority priority;
+	guint i;
+
+	ready_clients = g_ptr_array_new ();
+
+	for (i = 0; i < scheduler.clients->len; i++)
+	{
+		GspellSchedulerClient *client = g_ptr_array_index (scheduler.clients, i);
+
+		if (client_is_ready (client, background, now))
+		{
+			client->priority = client->priority_func (client->user_data);
+			g_ptr_array_add (ready_clients, client);
+		}
+	}
+
+	queue = g_ptr_array_sized_new (ready_clients->len);
+
+	for (priority = GSPELL_SCHEDULER_PRIORITY_FOCUSED;
+	     priority <= GSPELL_SCHEDULER_PRIORITY_HIDDEN;
+	     priority++)
+	{
+		for (i = 0; i < ready_clients->len; i++)
+		{
+			GspellSchedulerClient *client = g_ptr_array_index (ready_clients, i);
+
+			if (client->priority == priority)
+			{
+				g_ptr_array_add (queue, client);
+			}
+		}
+	}
+
+	g_ptr_array_unref (ready_clients);
+	return queue;
+}
+
+/* Moves the clients served by the dispatch to the end of the list, in one
+ * pass.
+ */
+static void
+move_served_clients_to_end (gboolean background)
+{
+	GPtrArray *served_clients;
+	guint n_kept = 0;
+	guint i;
+
+	served_clients = g_ptr_array_new ();
+
+	for (i = 0; i < scheduler.clients->len; i++)
+	{
+		GspellSchedulerClient *client = g_ptr_array_index (scheduler.clients, i);
+		gboolean served;
+
+		if (background)
+		{
+			served = client->background_serial == scheduler.background_serial;
+		}
+		else
+		{
+			served = client->check_serial == scheduler.check_serial;
+		}
+
+		if (served)
+		{
+			g_ptr_array_add (served_clients, client);
+		}
+		else
+		{
+			g_ptr_array_index (scheduler.clients, n_kept) = client;
+			n_kept++;
+		}
+	}
+
+	for (i = 0; i < served_clients->len; i++)
+	{
+		g_ptr_array_index (scheduler.clients, n_kept + i) = g_ptr_array_index (served_clients, i);
+	}
+
+	g_ptr_array_unref (served_clients);
+}
+
+static void
+begin_dispatch (void)
+{
+	scheduler.dispatch_depth++;
+}
+
+static void
+end_dispatch (void)
+{
+	scheduler.dispatch_depth--;
+
+	if (scheduler.dispatch_depth == 0)
+	{
+		g_slist_free_full (scheduler.removed_clients, g_free);
+		scheduler.removed_clients = NULL;
+	}
+}
+
+static gboolean
+check_source_dispatch (GSource     *source,
+		       GSourceFunc  callback,
+		       gpointer     user_data)
+{
+	gint64 now;
+	gint64 deadline;
+	GPtrArray *queue;
+	guint i;
+
+	now = g_get_monotonic_time ();
+	deadline = now + CHECK_TIME_BUDGET;
+	scheduler.check_serial++;
+	scheduler.next_dispatch_time = 0;
+
+	begin_dispatch ();
+
+	queue = get_dispatch_queue (FALSE, now);
+
+	for (i = 0; i < queue->len; i++)
+	{
+		GspellSchedulerClient *client = g_ptr_array_index (queue, i);
+
+		if (!client_is_ready (client, FALSE, now))
+		{
+			continue;
+		}
+
+		client->check_serial = scheduler.check_serial;
+
+		/* Until the client schedules a check again. */
+		client->check_time = -1;
+
+		client->check_func (client->user_data, deadline);
+
+		if (g_get_monotonic_time () >= deadline)
+		{
+			scheduler.next_dispatch_time = now + FRAME_INTERVAL;
+			break;
+		}
+	}
+
+	g_ptr_array_unref (queue);
+	move_served_clients_to_end (FALSE);
+	end_dispatch ();
+
+	update_check_source ();
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+has_background_work (void)
+{
+	guint i;
+
+	for (i = 0; i < scheduler.clients->len; i++)
+	{
+		GspellSchedulerClient *client = g_ptr_array_index (scheduler.clients, i);
+
+		if (client->background_work)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static gboolean
+background_cb (gpointer user_data)
+{
+	gint64 deadline;
+	GPtrArray *queue;
+	guint i;
+
+	deadline = g_get_monotonic_time () + BACKGROUND_TIME_BUDGET;
+	scheduler.background_serial++;
+
+	begin_dispatch ();
+
+	queue = get_dispatch_queue (TRUE, 0);
+
+	for (i = 0; i < queue->len; i++)
+	{
+		GspellSchedulerClient *client = g_ptr_array_index (queue, i);
+
+		if (!client_is_ready (client, TRUE, 0))
+		{
+			continue;
+		}
+
+		client->background_serial = scheduler.background_serial;
+
+		/* Unless there is work left, or the client adds some. */
+		client->background_work = FALSE;
+
+		if (!client->background_func (client->user_data, deadline) &&
+		    !client->removed)
+		{
+			client->background_work = TRUE;
+		}
+
+		if (g_get_monotonic_time () >= deadline)
+		{
+			break;
+		}
+	}
+
+	g_ptr_array_unref (queue);
+	move_served_clients_to_end (TRUE);
+	end_dispatch ();
+
+	/* Removed with the last client. */
+	if (g_source_is_destroyed (g_main_current_source ()))
+	{
+		return G_SOURCE_REMOVE;
+	}
+
+	if (!has_background_work ())
+	{
+		scheduler.background_id = 0;
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+GspellSchedulerClient *
+_gspell_scheduler_add_client (GspellSchedulerPriorityFunc   priority_func,
+			      GspellSchedulerCheckFunc      check_func,
+			      GspellSchedulerBackgroundFunc background_func,
+			      gpointer                      user_data)
+{
+	GspellSchedulerClient *client;
+
+	g_return_val_if_fail (priority_func != NULL, NULL);
+	g_return_val_if_fail (check_func != NULL, NULL);
+	g_return_val_if_fail (background_func != NULL, NULL);
+
+	if (scheduler.clients == NULL)
+	{
+		scheduler.clients = g_ptr_array_new ();
+	}
+
+	if (scheduler.check_source == NULL)
+	{
+		scheduler.check_source = g_source_new (&check_source_funcs, sizeof (GSource));
+		g_source_set_name (scheduler.check_source, "[gspell] scheduler");
+		g_source_attach (scheduler.check_source, NULL);
+	}
+
+	client = g_new0 (GspellSchedulerClient, 1);
+	client->priority_func = priority_func;
+	client->check_func = check_func;
+	client->background_func = background_func;
+	client->user_data = user_data;
+	client->check_time = -1;
+	client->check_serial = scheduler.check_serial;
+	client->background_serial = scheduler.background_serial;
+
+	g_ptr_array_add (scheduler.clients, client);
+
+	return client;
+}
+
+void
+_gspell_scheduler_remove_client (GspellSchedulerClient *client)
+{
+	g_return_if_fail (client != NULL);
+	g_return_if_fail (!client->removed);
+
+	g_ptr_array_remove (scheduler.clients, client);
+	client->removed = TRUE;
+	client->check_time = -1;
+	client->background_work = FALSE;
+
+	if (scheduler.dispatch_depth > 0)
+	{
+		scheduler.removed_clients = g_slist_prepend (scheduler.removed_clients, client);
+	}
+	else
+	{
+		g_free (client);
+	}
+
+	if (scheduler.clients->len == 0)
+	{
+		g_source_destroy (scheduler.check_source);
+		g_source_unref (scheduler.check_source);
+		scheduler.check_source = NULL;
+		scheduler.next_dispatch_time = 0;
+
+		if (scheduler.background_id != 0)
+		{
+			g_source_remove (scheduler.background_id);
+			scheduler.background_id = 0;
+		}
+	}
+	else
+	{
+		update_check_source ();
+	}
+}
+
+gint64
+_gspell_scheduler_get_check_time (GspellSchedulerClient *client)
+{
+	g_return_val_if_fail (client != NULL, -1);
+
+	return client->check_time;
+}
+
+/* @check_time is a time of g_get_monotonic_time(), or -1 to cancel the check. */
+void
+_gspell_scheduler_set_check_time (GspellSchedulerClient *client,
+				  gint64                 check_time)
+{
+	g_return_if_fail (client != NULL);
+	g_return_if_fail (!client->removed);
+
+	if (client->check_time != check_time)
+	{
+		client->check_time = check_time;
+		update_check_source ();
+	}
+}
+
+gboolean
+_gspell_scheduler_get_background_work (GspellSchedulerClient *client)
+{
+	g_return_val_if_fail (client != NULL, FALSE);
+
+	return client->background_work;
+}
+
+void
+_gspell_scheduler_set_background_work (GspellSchedulerClient *client,
+				       gboolean               background_work)
+{
+	g_return_if_fail (client != NULL);
+	g_return_if_fail (!client->removed);
+
+	client->background_work = background_work != FALSE;
+
+	/* The idle priority is lower than the input events and the redraws,
+	 * so the background work waits for them to be handled.
+	 */
+	if (client->background_work &&
+	    scheduler.background_id == 0)
+	{
+		scheduler.background_id = g_idle_add_full (G_PRIORITY_LOW,
+							   background_cb,
+							   NULL,
+							   NULL);
+	}
+}
+
+/* ex:set ts=8 noet: */
@@ -0,0 +1,75 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSPELL_SCHEDULER_H
+#define GSPELL_SCHEDULER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* In the order in which the clients are served. */
+typedef enum _GspellSchedulerPriority
+{
+	GSPELL_SCHEDULER_PRIORITY_FOCUSED,
+	GSPELL_SCHEDULER_PRIORITY_VISIBLE,
+	GSPELL_SCHEDULER_PRIORITY_HIDDEN,
+} GspellSchedulerPriority;
+
+typedef struct _GspellSchedulerClient GspellSchedulerClient;
+
+typedef GspellSchedulerPriority	(* GspellSchedulerPriorityFunc)	(gpointer user_data);
+
+/* Checks until @deadline, a time of g_get_monotonic_time(). */
+typedef void			(* GspellSchedulerCheckFunc)	(gpointer user_data,
+								 gint64   deadline);
+
+/* Same, and returns TRUE if there is no background work left. */
+typedef gboolean		(* GspellSchedulerBackgroundFunc) (gpointer user_data,
+								   gint64   deadline);
+
+G_GNUC_INTERNAL
+GspellSchedulerClient *
+		_gspell_scheduler_add_client		(GspellSchedulerPriorityFunc   priority_func,
+							 GspellSchedulerCheckFunc      check_func,
+							 GspellSchedulerBackgroundFunc background_func,
+							 gpointer                      user_data);
+
+G_GNUC_INTERNAL
+void		_gspell_scheduler_remove_client		(GspellSchedulerClient *client);
+
+G_GNUC_INTERNAL
+gint64		_gspell_scheduler_get_check_time	(GspellSchedulerClient *client);
+
+G_GNUC_INTERNAL
+void		_gspell_scheduler_set_check_time	(GspellSchedulerClient *client,
+							 gint64                 check_time);
+
+G_GNUC_INTERNAL
+gboolean	_gspell_scheduler_get_background_work	(GspellSchedulerClient *client);
+
+G_GNUC_INTERNAL
+void		_gspell_scheduler_set_background_work	(GspellSchedulerClient *client,
+							 gboolean               background_work);
+
+G_END_DECLS
+
+#endif /* GSPELL_SCHEDULER_H */
+
+/* ex:set ts=8 noet: */
@@ -22,6 +22,8 @@
 #endif
 
 #include "gspell-text-buffer.h"
+#include "gspell-text-buffer-private.h"
+#include "gspell-enum-types.h"
 
 /**
  * SECTION:text-buffer
@@ -56,6 +58,63 @@
  *
  * See the class description of #GtkSourceBuffer for more information about
  * context classes.
+ *
+ * # Markup languages
+ *
+ * When the #GtkTextBuffer contains a markup language like Markdown, HTML or
+ * LaTeX, set the #GspellTextBuffer:markup-mode property. gspell then skips the
+ * markup itself (tags, commands, link targets, code, etc) with built-in
+ * lightweight lexers, without the need of the no-spell-check tag. The lexers
+ * work line by line, so constructs spanning several lines are recognized only
+ * on the lines containing their delimiters.
+ *
+ * # Render modes
+ *
+ * By default the misspelled words are highlighted with a #GtkTextTag. On big
+ * buffers with many misspelled words, the tag applications slow down the other
+ * tag lookups (for example syntax highlighting) and invalidate the layout. With
+ * the %GSPELL_RENDER_MODE_OVERLAY #GspellTextBuffer:render-mode, the misspelled
+ * words are kept by gspell and drawn above the text, only for the visible
+ * lines.
+ *
+ * # Dense misspellings
+ *
+ * When nearly all the words of a text are misspelled (binary data, a base64
+ * dump, a language without dictionary), highlighting them would only slow
+ * down the editor. gspell then stops highlighting that text, and emits the
+ * #GspellTextBuffer::highlighting-suppressed signal, so that the application
+ * can tell the user. The highlighting is resumed after a language change, or
+ * with gspell_text_buffer_resume_highlighting().
+ *
+ * # Background scanning
+ *
+ * By default only the text visible in the #GtkTextView's is spell-checked, the
+ * rest of the buffer is checked when it is scrolled into view. When the
+ * #GspellTextBuffer:background-scanning property is enabled, the whole buffer
+ * is checked at idle priority, in small time slices to keep the user interface
+ * responsive. The #GspellTextBuffer::buffer-checked signal is emitted when the
+ * whole buffer has been checked, it is never emitted without background
+ * scanning.
+ *
+ * # Bulk edits
+ *
+ * Each edit of the #GtkTextBuffer is followed by some work to find the text to
+ * re-check, and by a check shortly after. When an application makes many
+ * edits in a row, for example when loading a file by chunks or during a
+ * search and replace over the whole document, it can surround them with
+ * gspell_text_buffer_freeze_checking() and
+ * gspell_text_buffer_thaw_checking(). While frozen, the edits only extend the
+ * range of text to re-check, which is checked once after the thaw.
+ *
+ * # Scan progress
+ *
+ * The #GspellTextBuffer:n-pending-chars property tells how much text remains
+ * to be spell-checked, and the #GspellTextBuffer::scan-idle signal is emitted
+ * each time the spell-checking has settled, with or without background
+ * scanning: when the visible text has been checked, or the whole buffer with
+ * the #GspellTextBuffer:background-scanning property. For example to show a
+ * progress indicator, or in tests to wait for the results instead of waiting
+ * for an arbitrary delay.
  */
 
 struct _GspellTextBuffer
@@ -64,6 +123,12 @@ struct _GspellTextBuffer
 
 	GtkTextBuffer *buffer;
 	GspellChecker *spell_checker;
+	GspellMarkupMode markup_mode;
+	GspellRenderMode render_mode;
+	guint freeze_count;
+	gint n_pending_chars;
+
+	guint background_scanning : 1;
 };
 
 enum
@@ -71,8 +136,24 @@ enum
 	PROP_0,
 	PROP_BUFFER,
 	PROP_SPELL_CHECKER,
+	PROP_MARKUP_MODE,
+	PROP_RENDER_MODE,
+	PROP_BACKGROUND_SCANNING,
+	PROP_CHECKING_FROZEN,
+	PROP_N_PENDING_CHARS,
+};
+
+enum
+{
+	SIGNAL_BUFFER_CHECKED,
+	SIGNAL_HIGHLIGHTING_SUPPRESSED,
+	SIGNAL_HIGHLIGHTING_RESUMED,
+	SIGNAL_SCAN_IDLE,
+	LAST_SIGNAL
 };
 
+static guint signals[LAST_SIGNAL] = { 0 };
+
 #define GSPELL_TEXT_BUFFER_KEY "gspell-text-buffer-key"
 
 G_DEFINE_TYPE (GspellTextBuffer, gspell_text_buffer, G_TYPE_OBJECT)
@@ -95,6 +176,26 @@ gspell_text_buffer_get_property (GObject    *object,
 			g_value_set_object (value, gspell_text_buffer_get_spell_checker (gspell_buffer));
 			break;
 
+		case PROP_MARKUP_MODE:
+			g_value_set_enum (value, gspell_text_buffer_get_markup_mode (gspell_buffer));
+			break;
+
+		case PROP_RENDER_MODE:
+			g_value_set_enum (value, gspell_text_buffer_get_render_mode (gspell_buffer));
+			break;
+
+		case PROP_BACKGROUND_SCANNING:
+			g_value_set_boolean (value, gspell_text_buffer_get_background_scanning (gspell_buffer));
+			break;
+
+		case PROP_CHECKING_FROZEN:
+			g_value_set_boolean (value, gspell_text_buffer_get_checking_frozen (gspell_buffer));
+			break;
+
+		case PROP_N_PENDING_CHARS:
+			g_value_set_int (value, gspell_text_buffer_get_n_pending_chars (gspell_buffer));
+			break;
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -120,6 +221,18 @@ gspell_text_buffer_set_property (GObject      *object,
 			gspell_text_buffer_set_spell_checker (gspell_buffer, g_value_get_object (value));
 			break;
 
+		case PROP_MARKUP_MODE:
+			gspell_text_buffer_set_markup_mode (gspell_buffer, g_value_get_enum (value));
+			break;
+
+		case PROP_RENDER_MODE:
+			gspell_text_buffer_set_render_mode (gspell_buffer, g_value_get_enum (value));
+			break;
+
+		case PROP_BACKGROUND_SCANNING:
+			gspell_text_buffer_set_background_scanning (gspell_buffer, g_value_get_boolean (value));
+			break;
+
 		default:
 			G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 			break;
@@ -174,6 +287,193 @@ gspell_text_buffer_class_init (GspellTextBufferClass *klass)
 							      GSPELL_TYPE_CHECKER,
 							      G_PARAM_READWRITE |
 							      G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GspellTextBuffer:markup-mode:
+	 *
+	 * The markup language of the #GtkTextBuffer content. The words that are
+	 * part of the markup are not spell-checked.
+	 *
+	 * Since: 4.2
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_MARKUP_MODE,
+					 g_param_spec_enum ("markup-mode",
+							    "Markup Mode",
+							    "",
+							    GSPELL_TYPE_MARKUP_MODE,
+							    GSPELL_MARKUP_MODE_NONE,
+							    G_PARAM_READWRITE |
+							    G_PARAM_EXPLICIT_NOTIFY |
+							    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GspellTextBuffer:render-mode:
+	 *
+	 * How the misspelled words are highlighted.
+	 *
+	 * Since: 4.2
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_RENDER_MODE,
+					 g_param_spec_enum ("render-mode",
+							    "Render Mode",
+							    "",
+							    GSPELL_TYPE_RENDER_MODE,
+							    GSPELL_RENDER_MODE_TAG,
+							    G_PARAM_READWRITE |
+							    G_PARAM_EXPLICIT_NOTIFY |
+							    G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GspellTextBuffer:background-scanning:
+	 *
+	 * Whether to spell-check the whole buffer in the background, not only
+	 * the text visible in the #GtkTextView's.
+	 *
+	 * Since: 4.2
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_BACKGROUND_SCANNING,
+					 g_param_spec_boolean ("background-scanning",
+							       "Background Scanning",
+							       "",
+							       FALSE,
+							       G_PARAM_READWRITE |
+							       G_PARAM_EXPLICIT_NOTIFY |
+							       G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GspellTextBuffer:checking-frozen:
+	 *
+	 * Whether the spell-checking is frozen, see
+	 * gspell_text_buffer_freeze_checking().
+	 *
+	 * Since: 4.2
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_CHECKING_FROZEN,
+					 g_param_spec_boolean ("checking-frozen",
+							       "Checking Frozen",
+							       "",
+							       FALSE,
+							       G_PARAM_READABLE |
+							       G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GspellTextBuffer:n-pending-chars:
+	 *
+	 * The number of characters not yet spell-checked. It is updated as the
+	 * checks progress, not at each edit. Without background scanning, the
+	 * text outside the visible area remains pending until it is scrolled
+	 * into view.
+	 *
+	 * Since: 4.2
+	 */
+	g_object_class_install_property (object_class,
+					 PROP_N_PENDING_CHARS,
+					 g_param_spec_int ("n-pending-chars",
+							   "Number of Pending Characters",
+							   "",
+							   0,
+							   G_MAXINT,
+							   0,
+							   G_PARAM_READABLE |
+							   G_PARAM_STATIC_STRINGS));
+
+	/**
+	 * GspellTextBuffer::buffer-checked:
+	 * @gspell_buffer: the #GspellTextBuffer.
+	 *
+	 * Emitted when the #GspellTextBuffer:background-scanning property is
+	 * enabled and the whole buffer has been spell-checked. The text
+	 * containing the cursor can be excluded if the user is still editing
+	 * the word.
+	 *
+	 * Unlike #GspellTextBuffer::scan-idle, it is never emitted without
+	 * background scanning, and it is not emitted while text remains to be
+	 * checked, even when no work is scheduled. When both signals follow
+	 * the same check, #GspellTextBuffer::buffer-checked is emitted first.
+	 *
+	 * Since: 4.2
+	 */
+	signals[SIGNAL_BUFFER_CHECKED] =
+		g_signal_new ("buffer-checked",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE,
+			      0);
+
+	/**
+	 * GspellTextBuffer::highlighting-suppressed:
+	 * @gspell_buffer: the #GspellTextBuffer.
+	 * @start: the start of the text.
+	 * @end: the end of the text.
+	 *
+	 * Emitted when the misspelled words between @start and @end are no
+	 * longer highlighted, because nearly all the words of that text are
+	 * misspelled. The highlighting is resumed after a language change, or
+	 * with gspell_text_buffer_resume_highlighting().
+	 *
+	 * Since: 4.2
+	 */
+	signals[SIGNAL_HIGHLIGHTING_SUPPRESSED] =
+		g_signal_new ("highlighting-suppressed",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE,
+			      2,
+			      GTK_TYPE_TEXT_ITER | G_SIGNAL_TYPE_STATIC_SCOPE,
+			      GTK_TYPE_TEXT_ITER | G_SIGNAL_TYPE_STATIC_SCOPE);
+
+	/**
+	 * GspellTextBuffer::highlighting-resumed:
+	 * @gspell_buffer: the #GspellTextBuffer.
+	 *
+	 * Emitted by gspell_text_buffer_resume_highlighting(), and after a
+	 * language change if the highlighting was suppressed. The text where it
+	 * was suppressed is spell-checked again.
+	 *
+	 * Since: 4.2
+	 */
+	signals[SIGNAL_HIGHLIGHTING_RESUMED] =
+		g_signal_new ("highlighting-resumed",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE,
+			      0);
+
+	/**
+	 * GspellTextBuffer::scan-idle:
+	 * @gspell_buffer: the #GspellTextBuffer.
+	 *
+	 * Emitted when the spell-checking has settled after a change: the
+	 * visible text has been checked, or with the
+	 * #GspellTextBuffer:background-scanning property the whole buffer. The
+	 * word containing the cursor can be excluded if the user is still
+	 * editing it.
+	 *
+	 * Unlike #GspellTextBuffer::buffer-checked, it is also emitted without
+	 * background scanning, when text outside of the views remains to be
+	 * checked: no more work is scheduled until the next change or scroll.
+	 * The remaining text is given by #GspellTextBuffer:n-pending-chars.
+	 *
+	 * Since: 4.2
+	 */
+	signals[SIGNAL_SCAN_IDLE] =
+		g_signal_new ("scan-idle",
+			      G_TYPE_FROM_CLASS (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL, NULL,
+			      G_TYPE_NONE,
+			      0);
 }
 
 static void
@@ -272,6 +572,273 @@ gspell_text_buffer_set_spell_checker (GspellTextBuffer *gspell_buffer,
 	}
 }
 
-/* ex:set ts=8 noet: */
+/**
+ * gspell_text_buffer_get_markup_mode:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Returns: the value of the #GspellTextBuffer:markup-mode property.
+ * Since: 4.2
+ */
+GspellMarkupMode
+gspell_text_buffer_get_markup_mode (GspellTextBuffer *gspell_buffer)
+{
+	g_return_val_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer), GSPELL_MARKUP_MODE_NONE);
+
+	return gspell_buffer->markup_mode;
+}
+
+/**
+ * gspell_text_buffer_set_markup_mode:
+ * @gspell_buffer: a #GspellTextBuffer.
+ * @markup_mode: the new #GspellMarkupMode.
+ *
+ * Sets the #GspellTextBuffer:markup-mode property. The whole buffer is
+ * re-checked.
+ *
+ * Since: 4.2
+ */
+void
+gspell_text_buffer_set_markup_mode (GspellTextBuffer *gspell_buffer,
+				    GspellMarkupMode  markup_mode)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+	g_return_if_fail (markup_mode <= GSPELL_MARKUP_MODE_RESTRUCTURED_TEXT);
+
+	if (gspell_buffer->markup_mode != markup_mode)
+	{
+		gspell_buffer->markup_mode = markup_mode;
+		g_object_notify (G_OBJECT (gspell_buffer), "markup-mode");
+	}
+}
 
+/**
+ * gspell_text_buffer_get_render_mode:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Returns: the value of the #GspellTextBuffer:render-mode property.
+ * Since: 4.2
+ */
+GspellRenderMode
+gspell_text_buffer_get_render_mode (GspellTextBuffer *gspell_buffer)
+{
+	g_return_val_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer), GSPELL_RENDER_MODE_TAG);
 
+	return gspell_buffer->render_mode;
+}
+
+/**
+ * gspell_text_buffer_set_render_mode:
+ * @gspell_buffer: a #GspellTextBuffer.
+ * @render_mode: the new #GspellRenderMode.
+ *
+ * Sets the #GspellTextBuffer:render-mode property. The whole buffer is
+ * re-checked.
+ *
+ * Since: 4.2
+ */
+void
+gspell_text_buffer_set_render_mode (GspellTextBuffer *gspell_buffer,
+				    GspellRenderMode  render_mode)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	if (gspell_buffer->render_mode != render_mode)
+	{
+		gspell_buffer->render_mode = render_mode;
+		g_object_notify (G_OBJECT (gspell_buffer), "render-mode");
+	}
+}
+
+/**
+ * gspell_text_buffer_resume_highlighting:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Resumes the highlighting of the misspelled words in the text where it has
+ * been suppressed, see #GspellTextBuffer::highlighting-suppressed. It is then
+ * no longer suppressed until the next language change.
+ *
+ * Since: 4.2
+ */
+void
+gspell_text_buffer_resume_highlighting (GspellTextBuffer *gspell_buffer)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	g_signal_emit (gspell_buffer, signals[SIGNAL_HIGHLIGHTING_RESUMED], 0);
+}
+
+/**
+ * gspell_text_buffer_get_background_scanning:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Returns: the value of the #GspellTextBuffer:background-scanning property.
+ * Since: 4.2
+ */
+gboolean
+gspell_text_buffer_get_background_scanning (GspellTextBuffer *gspell_buffer)
+{
+	g_return_val_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer), FALSE);
+
+	return gspell_buffer->background_scanning;
+}
+
+/**
+ * gspell_text_buffer_set_background_scanning:
+ * @gspell_buffer: a #GspellTextBuffer.
+ * @background_scanning: the new value.
+ *
+ * Sets the #GspellTextBuffer:background-scanning property.
+ *
+ * Since: 4.2
+ */
+void
+gspell_text_buffer_set_background_scanning (GspellTextBuffer *gspell_buffer,
+					    gboolean          background_scanning)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	background_scanning = background_scanning != FALSE;
+
+	if (gspell_buffer->background_scanning != background_scanning)
+	{
+		gspell_buffer->background_scanning = background_scanning;
+		g_object_notify (G_OBJECT (gspell_buffer), "background-scanning");
+	}
+}
+
+/**
+ * gspell_text_buffer_freeze_checking:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Freezes the spell-checking of @gspell_buffer, before many edits in a row.
+ * The edited text is spell-checked after the matching call to
+ * gspell_text_buffer_thaw_checking(). The calls can be nested.
+ *
+ * Since: 4.2
+ */
+void
+gspell_text_buffer_freeze_checking (GspellTextBuffer *gspell_buffer)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	gspell_buffer->freeze_count++;
+
+	if (gspell_buffer->freeze_count == 1)
+	{
+		g_object_notify (G_OBJECT (gspell_buffer), "checking-frozen");
+	}
+}
+
+/**
+ * gspell_text_buffer_thaw_checking:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Reverts the effect of a previous call to
+ * gspell_text_buffer_freeze_checking(). When the last freeze is reverted, the
+ * text edited in the meantime is spell-checked.
+ *
+ * Since: 4.2
+ */
+void
+gspell_text_buffer_thaw_checking (GspellTextBuffer *gspell_buffer)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+	g_return_if_fail (gspell_buffer->freeze_count > 0);
+
+	gspell_buffer->freeze_count--;
+
+	if (gspell_buffer->freeze_count == 0)
+	{
+		g_object_notify (G_OBJECT (gspell_buffer), "checking-frozen");
+	}
+}
+
+/**
+ * gspell_text_buffer_get_checking_frozen:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Returns: the value of the #GspellTextBuffer:checking-frozen property.
+ * Since: 4.2
+ */
+gboolean
+gspell_text_buffer_get_checking_frozen (GspellTextBuffer *gspell_buffer)
+{
+	g_return_val_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer), FALSE);
+
+	return gspell_buffer->freeze_count > 0;
+}
+
+/**
+ * gspell_text_buffer_get_n_pending_chars:
+ * @gspell_buffer: a #GspellTextBuffer.
+ *
+ * Returns: the value of the #GspellTextBuffer:n-pending-chars property.
+ * Since: 4.2
+ */
+gint
+gspell_text_buffer_get_n_pending_chars (GspellTextBuffer *gspell_buffer)
+{
+	g_return_val_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer), 0);
+
+	return gspell_buffer->n_pending_chars;
+}
+
+void
+_gspell_text_buffer_set_n_pending_chars (GspellTextBuffer *gspell_buffer,
+					 gint              n_pending_chars)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+	g_return_if_fail (n_pending_chars >= 0);
+
+	if (gspell_buffer->n_pending_chars != n_pending_chars)
+	{
+		gspell_buffer->n_pending_chars = n_pending_chars;
+		g_object_notify (G_OBJECT (gspell_buffer), "n-pending-chars");
+	}
+}
+
+void
+_gspell_text_buffer_emit_buffer_checked (GspellTextBuffer *gspell_buffer)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	g_signal_emit (gspell_buffer, signals[SIGNAL_BUFFER_CHECKED], 0);
+}
+
+void
+_gspell_text_buffer_emit_scan_idle (GspellTextBuffer *gspell_buffer)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	g_signal_emit (gspell_buffer, signals[SIGNAL_SCAN_IDLE], 0);
+}
+
+void
+_gspell_text_buffer_emit_highlighting_suppressed (GspellTextBuffer  *gspell_buffer,
+						  const GtkTextIter *start,
+						  const GtkTextIter *end)
+{
+	GtkTextIter start_copy;
+	GtkTextIter end_copy;
+
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	start_copy = *start;
+	end_copy = *end;
+
+	g_signal_emit (gspell_buffer,
+		       signals[SIGNAL_HIGHLIGHTING_SUPPRESSED],
+		       0,
+		       &start_copy,
+		       &end_copy);
+}
+
+void
+_gspell_text_buffer_emit_highlighting_resumed (GspellTextBuffer *gspell_buffer)
+{
+	g_return_if_fail (GSPELL_IS_TEXT_BUFFER (gspell_buffer));
+
+	g_signal_emit (gspell_buffer, signals[SIGNAL_HIGHLIGHTING_RESUMED], 0);
+}
+
+/* ex:set ts=8 noet: */
@@ -32,6 +32,46 @@ G_BEGIN_DECLS
 
 #define GSPELL_TYPE_TEXT_BUFFER (gspell_text_buffer_get_type ())
 
+/**
+ * GspellMarkupMode:
+ * @GSPELL_MARKUP_MODE_NONE: the text is spell-checked as-is.
+ * @GSPELL_MARKUP_MODE_MARKDOWN: Markdown.
+ * @GSPELL_MARKUP_MODE_HTML: HTML or XML.
+ * @GSPELL_MARKUP_MODE_LATEX: LaTeX.
+ * @GSPELL_MARKUP_MODE_RESTRUCTURED_TEXT: reStructuredText.
+ *
+ * The markup language of a #GspellTextBuffer. Words that are part of the
+ * markup (tags, commands, link targets, code, etc) are not spell-checked.
+ *
+ * Since: 4.2
+ */
+typedef enum _GspellMarkupMode
+{
+	GSPELL_MARKUP_MODE_NONE,
+	GSPELL_MARKUP_MODE_MARKDOWN,
+	GSPELL_MARKUP_MODE_HTML,
+	GSPELL_MARKUP_MODE_LATEX,
+	GSPELL_MARKUP_MODE_RESTRUCTURED_TEXT,
+} GspellMarkupMode;
+
+/**
+ * GspellRenderMode:
+ * @GSPELL_RENDER_MODE_TAG: the misspelled words are highlighted with a
+ *   #GtkTextTag applied to the #GtkTextBuffer.
+ * @GSPELL_RENDER_MODE_OVERLAY: the misspelled words are kept by gspell and
+ *   drawn above the text of the #GtkTextView's, the #GtkTextBuffer is not
+ *   modified.
+ *
+ * How the misspelled words of a #GspellTextBuffer are highlighted.
+ *
+ * Since: 4.2
+ */
+typedef enum _GspellRenderMode
+{
+	GSPELL_RENDER_MODE_TAG,
+	GSPELL_RENDER_MODE_OVERLAY,
+} GspellRenderMode;
+
 GSPELL_AVAILABLE_IN_ALL
 G_DECLARE_FINAL_TYPE (GspellTextBuffer, gspell_text_buffer,
 		      GSPELL, TEXT_BUFFER,
@@ -50,6 +90,42 @@ GSPELL_AVAILABLE_IN_ALL
 void			gspell_text_buffer_set_spell_checker		(GspellTextBuffer *gspell_buffer,
 									 GspellChecker    *spell_checker);
 
+GSPELL_AVAILABLE_IN_4_2
+GspellMarkupMode	gspell_text_buffer_get_markup_mode		(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+void			gspell_text_buffer_set_markup_mode		(GspellTextBuffer *gspell_buffer,
+									 GspellMarkupMode  markup_mode);
+
+GSPELL_AVAILABLE_IN_4_2
+GspellRenderMode	gspell_text_buffer_get_render_mode		(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+void			gspell_text_buffer_set_render_mode		(GspellTextBuffer *gspell_buffer,
+									 GspellRenderMode  render_mode);
+
+GSPELL_AVAILABLE_IN_4_2
+void			gspell_text_buffer_resume_highlighting		(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+gboolean		gspell_text_buffer_get_background_scanning	(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+void			gspell_text_buffer_set_background_scanning	(GspellTextBuffer *gspell_buffer,
+									 gboolean          background_scanning);
+
+GSPELL_AVAILABLE_IN_4_2
+void			gspell_text_buffer_freeze_checking		(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+void			gspell_text_buffer_thaw_checking		(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+gboolean		gspell_text_buffer_get_checking_frozen		(GspellTextBuffer *gspell_buffer);
+
+GSPELL_AVAILABLE_IN_4_2
+gint			gspell_text_buffer_get_n_pending_chars		(GspellTextBuffer *gspell_buffer);
+
 G_END_DECLS
 
 #endif /* GSPELL_TEXT_BUFFER_H */
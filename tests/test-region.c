@@ -0,0 +1,345 @@
+/*
+ * This file is part of gspell, a spell-checking library.
+ *
+ * Copyright 2026 - gspell contributors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gspell/gspell-region.h"
+
+static void
+get_iters (GspellRegion *region,
+	   gint          start_offset,
+	   gint          end_offset,
+	   GtkTextIter  *start,
+	   GtkTextIter  *end)
+{
+	GtkTextBuffer *buffer;
+
+	buffer = _gspell_region_get_buffer (region);
+	gtk_text_buffer_get_iter_at_offset (buffer, start, start_offset);
+	gtk_text_buffer_get_iter_at_offset (buffer, end, end_offset);
+}
+
+static void
+add_subregion (GspellRegion *region,
+	       gint          start_offset,
+	       gint          end_offset)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	get_iters (region, start_offset, end_offset, &start, &end);
+	_gspell_region_add_subregion (region, &start, &end);
+}
+
+static void
+subtract_subregion (GspellRegion *region,
+		    gint          start_offset,
+		    gint          end_offset)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	get_iters (region, start_offset, end_offset, &start, &end);
+	_gspell_region_subtract_subregion (region, &start, &end);
+}
+
+/* Edits the buffer, and reports the edit to @region like its owner does. */
+static void
+insert_text (GspellRegion *region,
+	     gint          offset,
+	     const gchar  *text)
+{
+	GtkTextBuffer *buffer;
+	GtkTextIter iter;
+
+	buffer = _gspell_region_get_buffer (region);
+	gtk_text_buffer_get_iter_at_offset (buffer, &iter, offset);
+	gtk_text_buffer_insert (buffer, &iter, text, -1);
+
+	_gspell_region_insert_text (region, offset, g_utf8_strlen (text, -1));
+}
+
+static void
+delete_text (GspellRegion *region,
+	     gint          start_offset,
+	     gint          end_offset)
+{
+	GtkTextIter start;
+	GtkTextIter end;
+
+	get_iters (region, start_offset, end_offset, &start, &end);
+	gtk_text_buffer_delete (_gspell_region_get_buffer (region), &start, &end);
+
+	_gspell_region_delete_text (region, start_offset, end_offset);
+}
+
+static void
+check_region (GspellRegion *region,
+	      const gchar  *expected_subregions)
+{
+	gchar *subregions;
+
+	subregions = _gspell_region_to_string (region);
+	g_assert_cmpstr (subregions, ==, expected_subregions);
+	g_free (subregions);
+}
+
+static GspellRegion *
+create_region (GtkTextBuffer *buffer,
+	       const gchar   *text)
+{
+	gtk_text_buffer_set_text (buffer, text, -1);
+	return _gspell_region_new (buffer);
+}
+
+static void
+test_gravities (void)
+{
+	GtkTextBuffer *buffer;
+	GspellRegion *region;
+
+	buffer = gtk_text_buffer_new (NULL);
+	region = create_region (buffer, "hello world");
+
+	add_subregion (region, 6, 11);
+	check_region (region, "Subregions: 6-11");
+
+	/* The start has a left gravity. */
+	insert_text (region, 6, "X");
+	check_region (region, "Subregions: 6-12");
+
+	/* The end has a right gravity. */
+	insert_text (region, 12, "Y");
+	check_region (region, "Subregions: 6-13");
+
+	insert_text (region, 0, "Z");
+	check_region (region, "Subregions: 7-14");
+	g_object_unref (region);
+
+	/* Interlaced subregions, see the comment in gspell-region.c. */
+	region = create_region (buffer, "hello world");
+	add_subregion (region, 0, 5);
+	add_subregion (region, 6, 11);
+
+	delete_text (region, 5, 6);
+	check_region (region, "Subregions: 0-5 5-10");
+
+	insert_text (region, 5, " ");
+	check_region (region, "Subregions: 0-6 5-11");
+	g_assert_cmpint (_gspell_region_get_n_chars (region), ==, 12);
+
+	g_object_unref (region);
+	g_object_unref (buffer);
+}
+
+static void
+test_emptied_subregion (void)
+{
+	GtkTextBuffer *buffer;
+	GspellRegion *region;
+
+	buffer = gtk_text_buffer_new (NULL);
+	region = create_region (buffer, "hello world foo");
+
+	add_subregion (region, 0, 5);
+	add_subregion (region, 6, 11);
+	add_subregion (region, 12, 15);
+
+	delete_text (region, 6, 11);
+	check_region (region, "Subregions: 0-5 7-10");
+
+	delete_text (region, 1, 2);
+	check_region (region, "Subregions: 0-4 6-9");
+
+	delete_text (region, 0, 9);
+	check_region (region, "Subregions:");
+	g_assert_true (_gspell_region_is_empty (region));
+
+	g_object_unref (region);
+	g_object_unref (buffer);
+}
+
+/* The edits of a run of keystrokes are merged in the log. The result must be
+ * the same as with the edits applied one by one.
+ */
+static void
+test_merged_edits (void)
+{
+	GtkTextBuffer *buffer;
+	GspellRegion *region;
+
+	buffer = gtk_text_buffer_new (NULL);
+	region = create_region (buffer, "abcdefghijklmnopqrst");
+
+	add_subregion (region, 2, 4);
+	add_subregion (region, 10, 12);
+	add_subregion (region, 16, 18);
+
+	/* Backspace key. */
+	delete_text (region, 8, 9);
+	delete_text (region, 7, 8);
+	delete_text (region, 6, 7);
+	check_region (region, "Subregions: 2-4 7-9 13-15");
+
+	/* Delete key. */
+	delete_text (region, 5, 6);
+	delete_text (region, 5, 6);
+	check_region (region, "Subregions: 2-4 5-7 11-13");
+
+	/* Typing, with a correction inside the typed text. */
+	insert_text (region, 0, "x");
+	insert_text (region, 1, "y");
+	delete_text (region, 1, 2);
+	insert_text (region, 1, "z");
+	check_region (region, "Subregions: 4-6 7-9 13-15");
+
+	g_object_unref (region);
+	g_object_unref (buffer);
+}
+
+/* More edits than MAX_PENDING_EDITS, which can't be merged. */
+static void
+test_max_pending_edits (void)
+{
+	GtkTextBuffer *buffer;
+	GspellRegion *region;
+	GString *text;
+	gint i;
+
+	text = g_string_new (NULL);
+	for (i = 0; i < 200; i++)
+	{
+		g_string_append_c (text, 'a');
+	}
+
+	buffer = gtk_text_buffer_new (NULL);
+	region = create_region (buffer, text->str);
+	g_string_free (text, TRUE);
+
+	add_subregion (region, 100, 110);
+
+	for (i = 0; i < 100; i++)
+	{
+		insert_text (region, 0, "b");
+	}
+	check_region (region, "Subregions: 200-210");
+
+	/* Every other character of the first 200. */
+	for (i = 0; i < 100; i++)
+	{
+		delete_text (region, i, i + 1);
+	}
+	check_region (region, "Subregions: 100-110");
+
+	g_object_unref (region);
+	g_object_unref (buffer);
+}
+
+static void
+test_set_operations (void)
+{
+	GtkTextBuffer *buffer;
+	GspellRegion *region_a;
+	GspellRegion *region_b;
+	GspellRegion *region_c;
+	GspellRegion *intersection;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	buffer = gtk_text_buffer_new (NULL);
+	region_a = create_region (buffer, "abcdefghijklmnopqrstuvwxyz0123");
+
+	/* Add, with the adjacent and overlapping subregions merged. */
+	add_subregion (region_a, 0, 5);
+	add_subregion (region_a, 10, 15);
+	add_subregion (region_a, 5, 8);
+	check_region (region_a, "Subregions: 0-8 10-15");
+
+	add_subregion (region_a, 12, 20);
+	check_region (region_a, "Subregions: 0-8 10-20");
+	g_assert_cmpint (_gspell_region_get_n_chars (region_a), ==, 18);
+
+	g_assert_true (_gspell_region_get_bounds (region_a, &start, &end));
+	g_assert_cmpint (gtk_text_iter_get_offset (&start), ==, 0);
+	g_assert_cmpint (gtk_text_iter_get_offset (&end), ==, 20);
+
+	/* Subtract. */
+	subtract_subregion (region_a, 3, 12);
+	check_region (region_a, "Subregions: 0-3 12-20");
+
+	region_b = _gspell_region_new (buffer);
+	add_subregion (region_b, 2, 4);
+	add_subregion (region_b, 6, 14);
+	add_subregion (region_b, 18, 25);
+
+	/* Intersect, the operands are not modified. */
+	intersection = _gspell_region_intersect_region (region_a, region_b);
+	check_region (intersection, "Subregions: 2-3 12-14 18-20");
+	g_object_unref (intersection);
+
+	get_iters (region_a, 1, 15, &start, &end);
+	intersection = _gspell_region_intersect_subregion (region_a, &start, &end);
+	check_region (intersection, "Subregions: 1-3 12-15");
+	g_object_unref (intersection);
+
+	check_region (region_a, "Subregions: 0-3 12-20");
+	check_region (region_b, "Subregions: 2-4 6-14 18-25");
+
+	/* Union and difference of regions. */
+	region_c = _gspell_region_new (buffer);
+	_gspell_region_set_region (region_c, region_a);
+	check_region (region_c, "Subregions: 0-3 12-20");
+
+	_gspell_region_add_region (region_c, region_b);
+	check_region (region_c, "Subregions: 0-4 6-25");
+
+	_gspell_region_subtract_region (region_c, region_a);
+	check_region (region_c, "Subregions: 3-4 6-12 20-25");
+
+	/* The in-place variants. */
+	get_iters (region_c, 4, 22, &start, &end);
+	_gspell_region_intersect_subregion_in_place (region_c, &start, &end);
+	check_region (region_c, "Subregions: 6-12 20-22");
+
+	_gspell_region_intersect_region_in_place (region_a, region_b);
+	check_region (region_a, "Subregions: 2-3 12-14 18-20");
+
+	_gspell_region_subtract_region (region_a, region_b);
+	g_assert_true (_gspell_region_is_empty (region_a));
+
+	g_object_unref (region_a);
+	g_object_unref (region_b);
+	g_object_unref (region_c);
+	g_object_unref (buffer);
+}
+
+gint
+main (gint    argc,
+      gchar **argv)
+{
+	gtk_test_init (&argc, &argv);
+
+	g_test_add_func ("/region/gravities", test_gravities);
+	g_test_add_func ("/region/emptied-subregion", test_emptied_subregion);
+	g_test_add_func ("/region/merged-edits", test_merged_edits);
+	g_test_add_func ("/region/max-pending-edits", test_max_pending_edits);
+	g_test_add_func ("/region/set-operations", test_set_operations);
+
+	return g_test_run ();
+}
+
+/* ex:set ts=8 noet: */
@@ -524,6 +524,725 @@ test_apostrophes (void)
 	g_object_unref (buffer);
 }
 
+static void
+test_markup_mode (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	gtk_text_buffer_set_text (buffer, "<p class=\"zzxq\">Hello wrold</p>", -1);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 10, 14,
+				 22, 27,
+				 -1);
+
+	/* The attribute value is no longer checked. */
+	gspell_text_buffer_set_markup_mode (gspell_buffer, GSPELL_MARKUP_MODE_HTML);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 22, 27,
+				 -1);
+
+	gtk_text_buffer_set_text (buffer, "\\label{sec:zzxq} Hello wrold % zzxq", -1);
+	gspell_text_buffer_set_markup_mode (gspell_buffer, GSPELL_MARKUP_MODE_LATEX);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 23, 28,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+buffer_checked_cb (GspellTextBuffer *gspell_buffer,
+		   gint             *n_emissions)
+{
+	(*n_emissions)++;
+}
+
+static void
+test_background_scanning (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	gint n_emissions = 0;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	gspell_text_buffer_set_background_scanning (gspell_buffer, TRUE);
+
+	g_signal_connect (gspell_buffer,
+			  "buffer-checked",
+			  G_CALLBACK (buffer_checked_cb),
+			  &n_emissions);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+	g_assert_cmpint (n_emissions, ==, 1);
+
+	n_emissions = 0;
+	gtk_text_buffer_set_text (buffer, "Hello jlyxdt", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 12,
+				 -1);
+	g_assert_cmpint (n_emissions, >, 0);
+
+	/* Nothing to check, no emission. */
+	n_emissions = 0;
+	gspell_text_buffer_set_background_scanning (gspell_buffer, FALSE);
+	gspell_text_buffer_set_background_scanning (gspell_buffer, TRUE);
+	g_assert_cmpint (n_emissions, ==, 0);
+
+	g_signal_handlers_disconnect_by_func (gspell_buffer, buffer_checked_cb, &n_emissions);
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+test_paragraph_memo (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellChecker *checker;
+	GspellInlineCheckerTextBuffer *inline_checker;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	checker = gspell_text_buffer_get_spell_checker (gspell_buffer);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	/* The second paragraph is found in the memo. */
+	gtk_text_buffer_set_text (buffer, "Hello wrold\nHello wrold", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 11,
+				 18, 23,
+				 -1);
+
+	/* The memoized verdicts are no longer valid. */
+	gspell_checker_add_word_to_session (checker, "wrold", -1);
+	gtk_text_buffer_set_text (buffer, "Hello wrold\nHello wrold", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+test_no_spell_check_region (void)
+{
+	GtkTextBuffer *buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	buffer = create_buffer ();
+	gtk_text_buffer_create_tag (buffer, "gtksourceview:context-classes:no-spell-check", NULL);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	gtk_text_buffer_set_text (buffer, "wrold wrold wroldwrold", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 0, 5,
+				 6, 11,
+				 12, 22,
+				 -1);
+
+	/* A word inside the region or cut by it is not checked. */
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 6);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, 11);
+	gtk_text_buffer_apply_tag_by_name (buffer, "gtksourceview:context-classes:no-spell-check", &start, &end);
+
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 15);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, 17);
+	gtk_text_buffer_apply_tag_by_name (buffer, "gtksourceview:context-classes:no-spell-check", &start, &end);
+
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 0, 5,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+test_word_added (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellChecker *checker;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextIter iter;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	checker = gspell_text_buffer_get_spell_checker (gspell_buffer);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	gtk_text_buffer_set_text (buffer, "wrold hlelo wrold wrol", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 0, 5,
+				 6, 11,
+				 12, 17,
+				 18, 22,
+				 -1);
+
+	/* The last word becomes an occurrence. */
+	gtk_text_buffer_get_end_iter (buffer, &iter);
+	gtk_text_buffer_insert (buffer, &iter, "d", -1);
+
+	gspell_checker_add_word_to_session (checker, "wrold", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 11,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static guint
+count_marks (GtkTextBuffer *buffer)
+{
+	GtkTextIter iter;
+	guint n_marks = 0;
+
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+
+	do
+	{
+		GSList *marks = gtk_text_iter_get_marks (&iter);
+
+		n_marks += g_slist_length (marks);
+		g_slist_free (marks);
+	}
+	while (gtk_text_iter_forward_char (&iter));
+
+	/* At the end iter. */
+	{
+		GSList *marks = gtk_text_iter_get_marks (&iter);
+
+		n_marks += g_slist_length (marks);
+		g_slist_free (marks);
+	}
+
+	return n_marks;
+}
+
+static void
+test_render_mode (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	guint n_marks;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	gspell_text_buffer_set_render_mode (gspell_buffer, GSPELL_RENDER_MODE_OVERLAY);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	n_marks = count_marks (buffer);
+
+	/* The buffer is not modified, no marks are created. */
+	gtk_text_buffer_set_text (buffer, "Hello wrold", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 -1);
+	g_assert_cmpuint (count_marks (buffer), ==, n_marks);
+
+	gspell_text_buffer_set_render_mode (gspell_buffer, GSPELL_RENDER_MODE_TAG);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 11,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+highlighting_suppressed_cb (GspellTextBuffer  *gspell_buffer,
+			    const GtkTextIter *start,
+			    const GtkTextIter *end,
+			    gint              *n_emissions)
+{
+	(*n_emissions)++;
+}
+
+static void
+test_dense_misspellings (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextTag *tag;
+	GtkTextIter iter;
+	GString *text;
+	gint n_emissions = 0;
+	gint i;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+
+	g_signal_connect (gspell_buffer,
+			  "highlighting-suppressed",
+			  G_CALLBACK (highlighting_suppressed_cb),
+			  &n_emissions);
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	/* Signalled once for the whole check pass. */
+	text = g_string_new (NULL);
+	for (i = 0; i < 200; i++)
+	{
+		g_string_append (text, "wrold ");
+	}
+
+	gtk_text_buffer_set_text (buffer, text->str, -1);
+	g_string_free (text, TRUE);
+
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 -1);
+	g_assert_cmpint (n_emissions, ==, 1);
+
+	/* Not suppressed again after the explicit request. */
+	gspell_text_buffer_resume_highlighting (gspell_buffer);
+
+	tag = _gspell_inline_checker_text_buffer_get_highlight_tag (inline_checker);
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+	g_assert_true (gtk_text_iter_starts_tag (&iter, tag));
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+test_freeze_checking (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextIter start;
+	GtkTextIter end;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	gtk_text_buffer_set_text (buffer, "hello wrold", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 11,
+				 -1);
+
+	gspell_text_buffer_freeze_checking (gspell_buffer);
+	g_assert_true (gspell_text_buffer_get_checking_frozen (gspell_buffer));
+
+	/* "hello wrold" -> "nrst hello wrold" -> "nrst hello wrold kwx" */
+	gtk_text_buffer_get_start_iter (buffer, &start);
+	gtk_text_buffer_insert (buffer, &start, "nrst ", -1);
+	gtk_text_buffer_get_end_iter (buffer, &end);
+	gtk_text_buffer_insert (buffer, &end, " kwx", -1);
+
+	/* "nrst hello wrold kwx" -> "nrst hello world kwx" */
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 12);
+	gtk_text_buffer_get_iter_at_offset (buffer, &end, 13);
+	gtk_text_buffer_delete (buffer, &start, &end);
+	gtk_text_buffer_get_iter_at_offset (buffer, &start, 13);
+	gtk_text_buffer_insert (buffer, &start, "r", -1);
+
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 11, 16, /* not yet re-checked */
+				 -1);
+
+	gspell_text_buffer_thaw_checking (gspell_buffer);
+	g_assert_false (gspell_text_buffer_get_checking_frozen (gspell_buffer));
+
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 0, 4,
+				 17, 20,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+scan_idle_cb (GspellTextBuffer *gspell_buffer,
+	      gint             *n_emissions)
+{
+	(*n_emissions)++;
+}
+
+static void
+test_scan_idle (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextIter end;
+	gint n_emissions = 0;
+	gint n_buffer_checked_emissions = 0;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	g_signal_connect (gspell_buffer,
+			  "scan-idle",
+			  G_CALLBACK (scan_idle_cb),
+			  &n_emissions);
+	g_signal_connect (gspell_buffer,
+			  "buffer-checked",
+			  G_CALLBACK (buffer_checked_cb),
+			  &n_buffer_checked_emissions);
+
+	/* Without background scanning, only scan-idle is emitted. */
+	gtk_text_buffer_set_text (buffer, "hello wrold", -1);
+	g_assert_cmpint (n_emissions, >, 0);
+	g_assert_cmpint (n_buffer_checked_emissions, ==, 0);
+	g_assert_cmpint (gspell_text_buffer_get_n_pending_chars (gspell_buffer), ==, 0);
+
+	/* No emission while frozen. */
+	gspell_text_buffer_freeze_checking (gspell_buffer);
+	n_emissions = 0;
+	gtk_text_buffer_get_end_iter (buffer, &end);
+	gtk_text_buffer_insert (buffer, &end, " kwx", -1);
+	g_assert_cmpint (n_emissions, ==, 0);
+
+	gspell_text_buffer_thaw_checking (gspell_buffer);
+	g_assert_cmpint (n_emissions, >, 0);
+	g_assert_cmpint (gspell_text_buffer_get_n_pending_chars (gspell_buffer), ==, 0);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 11,
+				 12, 15,
+				 -1);
+
+	g_signal_handlers_disconnect_by_func (gspell_buffer, scan_idle_cb, &n_emissions);
+	g_signal_handlers_disconnect_by_func (gspell_buffer, buffer_checked_cb, &n_buffer_checked_emissions);
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+static void
+scan_idle_flag_cb (GspellTextBuffer *gspell_buffer,
+		   gboolean         *scan_idle)
+{
+	*scan_idle = TRUE;
+}
+
+static gboolean
+scan_idle_timeout_cb (gpointer user_data)
+{
+	g_error ("GspellTextBuffer::scan-idle not emitted.");
+	return G_SOURCE_REMOVE;
+}
+
+/* Without the unit test mode: iterates the main context until the checks,
+ * the worker threads included, have settled.
+ */
+static void
+wait_for_scan_idle (GspellTextBuffer *gspell_buffer)
+{
+	gboolean scan_idle = FALSE;
+	gulong handler_id;
+	guint timeout_id;
+
+	handler_id = g_signal_connect (gspell_buffer,
+				       "scan-idle",
+				       G_CALLBACK (scan_idle_flag_cb),
+				       &scan_idle);
+	timeout_id = g_timeout_add_seconds (30, scan_idle_timeout_cb, NULL);
+
+	while (!scan_idle)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	g_source_remove (timeout_id);
+	g_signal_handler_disconnect (gspell_buffer, handler_id);
+}
+
+static gint
+count_highlighted_words (GtkTextBuffer                 *buffer,
+			 GspellInlineCheckerTextBuffer *inline_checker)
+{
+	GtkTextTag *tag;
+	GtkTextIter iter;
+	gint n_words = 0;
+
+	tag = _gspell_inline_checker_text_buffer_get_highlight_tag (inline_checker);
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+
+	while (gtk_text_iter_forward_to_tag_toggle (&iter, tag))
+	{
+		if (gtk_text_iter_starts_tag (&iter, tag))
+		{
+			n_words++;
+		}
+	}
+
+	return n_words;
+}
+
+/* The worker threads, with buffer edits while their results are in flight. */
+static void
+test_worker_threads (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextIter iter;
+	gint i;
+
+	buffer = create_buffer ();
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	gspell_text_buffer_set_background_scanning (gspell_buffer, TRUE);
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+
+	gtk_text_buffer_set_text (buffer, "hello wrold", -1);
+
+	for (i = 0; i < 5; i++)
+	{
+		g_main_context_iteration (NULL, TRUE);
+
+		gtk_text_buffer_get_end_iter (buffer, &iter);
+		gtk_text_buffer_insert (buffer, &iter, " nrst", -1);
+	}
+
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+	gtk_text_buffer_place_cursor (buffer, &iter);
+
+	wait_for_scan_idle (gspell_buffer);
+	g_assert_cmpint (gspell_text_buffer_get_n_pending_chars (gspell_buffer), ==, 0);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 6, 11,
+				 12, 16,
+				 17, 21,
+				 22, 26,
+				 27, 31,
+				 32, 36,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+/* A buffer big enough for the bulk check, modified while it runs. */
+static void
+test_bulk_check (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GString *text;
+	GtkTextIter iter;
+	gint i;
+
+	text = g_string_new (NULL);
+	for (i = 0; i < 8000; i++)
+	{
+		g_string_append (text, "hello wrold\n");
+	}
+
+	buffer = create_buffer ();
+	gtk_text_buffer_set_text (buffer, text->str, -1);
+	g_string_free (text, TRUE);
+
+	gtk_text_buffer_get_start_iter (buffer, &iter);
+	gtk_text_buffer_place_cursor (buffer, &iter);
+
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	gspell_text_buffer_set_background_scanning (gspell_buffer, TRUE);
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+
+	/* In a chunk not yet applied. */
+	gtk_text_buffer_get_iter_at_line (buffer, &iter, 4000);
+	gtk_text_buffer_insert (buffer, &iter, "nrst ", -1);
+
+	wait_for_scan_idle (gspell_buffer);
+	g_assert_cmpint (gspell_text_buffer_get_n_pending_chars (gspell_buffer), ==, 0);
+	g_assert_cmpint (count_highlighted_words (buffer, inline_checker), ==, 8001);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+/* A word added to the session while the bulk check runs. */
+static void
+test_bulk_check_word_added (void)
+{
+	GtkTextBuffer *buffer;
+	GspellTextBuffer *gspell_buffer;
+	GspellChecker *checker;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GString *text;
+	gint i;
+
+	text = g_string_new (NULL);
+	for (i = 0; i < 8000; i++)
+	{
+		g_string_append (text, "hello wrold nrst\n");
+	}
+
+	buffer = create_buffer ();
+	gtk_text_buffer_set_text (buffer, text->str, -1);
+	g_string_free (text, TRUE);
+
+	gspell_buffer = gspell_text_buffer_get_from_gtk_text_buffer (buffer);
+	checker = gspell_text_buffer_get_spell_checker (gspell_buffer);
+	gspell_text_buffer_set_background_scanning (gspell_buffer, TRUE);
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+
+	gspell_checker_add_word_to_session (checker, "wrold", -1);
+
+	wait_for_scan_idle (gspell_buffer);
+	g_assert_cmpint (gspell_text_buffer_get_n_pending_chars (gspell_buffer), ==, 0);
+	g_assert_cmpint (count_highlighted_words (buffer, inline_checker), ==, 8000);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+/* A giant line in the middle of a view: only a window around its displayed
+ * text is checked, the rest stays in the scan region.
+ */
+static void
+test_long_line (void)
+{
+	GtkTextBuffer *buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkWidget *window;
+	GtkWidget *view;
+	GString *text;
+	gint long_line_start;
+	gint long_line_end;
+	gint i;
+
+	text = g_string_new ("hello\nhello\nhello\n");
+
+	long_line_start = text->len;
+	g_string_append (text, "wrold");
+	for (i = 0; i < 4000; i++)
+	{
+		g_string_append (text, " hello");
+	}
+	g_string_append (text, " nrst");
+	long_line_end = text->len;
+
+	g_string_append (text, "\nhello\nkwx\nhello\n");
+
+	buffer = create_buffer ();
+	gtk_text_buffer_set_text (buffer, text->str, -1);
+	g_string_free (text, TRUE);
+
+	view = gtk_text_view_new_with_buffer (buffer);
+	window = gtk_window_new ();
+	gtk_window_set_default_size (GTK_WINDOW (window), 400, 300);
+	gtk_window_set_child (GTK_WINDOW (window), view);
+	gtk_window_present (GTK_WINDOW (window));
+
+	while (!gtk_widget_get_mapped (view) ||
+	       gtk_widget_get_height (view) == 0)
+	{
+		g_main_context_iteration (NULL, TRUE);
+	}
+
+	while (g_main_context_pending (NULL))
+	{
+		g_main_context_iteration (NULL, FALSE);
+	}
+
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_attach_view (inline_checker, GTK_TEXT_VIEW (view));
+	wait_for_scan_idle (gspell_text_buffer_get_from_gtk_text_buffer (buffer));
+
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 long_line_start, long_line_start + 5,
+				 long_line_end + 7, long_line_end + 10,
+				 -1);
+
+	_gspell_inline_checker_text_buffer_detach_view (inline_checker, GTK_TEXT_VIEW (view));
+	gtk_window_destroy (GTK_WINDOW (window));
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
+/* Editing a word at the cursor, one character at a time. */
+static void
+test_typed_word (void)
+{
+	GtkTextBuffer *buffer;
+	GspellInlineCheckerTextBuffer *inline_checker;
+	GtkTextIter iter;
+
+	buffer = create_buffer ();
+	inline_checker = _gspell_inline_checker_text_buffer_new (buffer);
+	_gspell_inline_checker_text_buffer_set_unit_test_mode (inline_checker, TRUE);
+
+	gtk_text_buffer_set_text (buffer, "wrold hello", -1);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 0, 5,
+				 -1);
+
+	/* "wr|old hello" -> "wrxy|old hello" */
+	gtk_text_buffer_get_iter_at_offset (buffer, &iter, 2);
+	gtk_text_buffer_place_cursor (buffer, &iter);
+	gtk_text_buffer_insert_at_cursor (buffer, "x", -1);
+	gtk_text_buffer_insert_at_cursor (buffer, "y", -1);
+	check_highlighted_words (buffer, inline_checker, -1);
+
+	/* "wrxy|old hello" -> "wrx|old hello" */
+	gtk_text_buffer_get_iter_at_offset (buffer, &iter, 4);
+	gtk_text_buffer_backspace (buffer, &iter, TRUE, TRUE);
+	check_highlighted_words (buffer, inline_checker, -1);
+
+	/* Cursor movement -> the edited word is checked. */
+	gtk_text_buffer_get_end_iter (buffer, &iter);
+	gtk_text_buffer_place_cursor (buffer, &iter);
+	check_highlighted_words (buffer,
+				 inline_checker,
+				 0, 6,
+				 -1);
+
+	g_object_unref (inline_checker);
+	g_object_unref (buffer);
+}
+
 gint
 main (gint    argc,
       gchar **argv)
@@ -545,5 +1264,47 @@ main (gint    argc,
 	g_test_add_func ("/inline-checker-text-buffer/apostrophes",
 			 test_apostrophes);
 
+	g_test_add_func ("/inline-checker-text-buffer/markup-mode",
+			 test_markup_mode);
+
+	g_test_add_func ("/inline-checker-text-buffer/background-scanning",
+			 test_background_scanning);
+
+	g_test_add_func ("/inline-checker-text-buffer/paragraph-memo",
+			 test_paragraph_memo);
+
+	g_test_add_func ("/inline-checker-text-buffer/no-spell-check-region",
+			 test_no_spell_check_region);
+
+	g_test_add_func ("/inline-checker-text-buffer/word-added",
+			 test_word_added);
+
+	g_test_add_func ("/inline-checker-text-buffer/render-mode",
+			 test_render_mode);
+
+	g_test_add_func ("/inline-checker-text-buffer/dense-misspellings",
+			 test_dense_misspellings);
+
+	g_test_add_func ("/inline-checker-text-buffer/freeze-checking",
+			 test_freeze_checking);
+
+	g_test_add_func ("/inline-checker-text-buffer/scan-idle",
+			 test_scan_idle);
+
+	g_test_add_func ("/inline-checker-text-buffer/worker-threads",
+			 test_worker_threads);
+
+	g_test_add_func ("/inline-checker-text-buffer/bulk-check",
+			 test_bulk_check);
+
+	g_test_add_func ("/inline-checker-text-buffer/bulk-check-word-added",
+			 test_bulk_check_word_added);
+
+	g_test_add_func ("/inline-checker-text-buffer/long-line",
+			 test_long_line);
+
+	g_test_add_func ("/inline-checker-text-buffer/typed-word",
+			 test_typed_word);
+
 	return g_test_run ();
 }